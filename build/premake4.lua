@@ -1,6 +1,33 @@
 solution "crust"
     configurations { "debug", "release" }
 
+    -- Bakes the data directory into the asset pack that the game maps at
+    -- startup, next to the executables. The game projects depend on it,
+    -- and run it before every build so that edits to the data are picked
+    -- up.
+    project "crust-packer"
+        kind "ConsoleApp"
+        language "C++"
+        files {
+            "../tools/**.cpp",
+            "../src/asset_pack.hpp",
+            "../src/error.hpp",
+            "../src/graphics/font.*",
+            "../src/graphics/font_packer.*",
+            "../src/graphics/font_reader.*"
+        }
+        includedirs { "../src", "../src/graphics" }
+
+        configuration "debug"
+           defines { "DEBUG" }
+           flags { "Symbols" }
+           targetdir "bin/debug"
+
+        configuration "release"
+           defines { "NDEBUG" }
+           flags { "Optimize" }
+           targetdir "bin/release"
+
     project "crust"
         kind "ConsoleApp"
         language "C++"
@@ -12,18 +39,51 @@ solution "crust"
             "../ext/SDL/include"
         }
         libdirs { "../ext/Box2D/lib", "../ext/SDL/lib" }
-        links { "Box2D", "SDL" }
+        -- The packer is not a library, so this only makes it build first.
+        links { "Box2D", "SDL", "crust-packer" }
         defines { "GL_GLEXT_PROTOTYPES" }
 
         configuration "debug"
            defines { "DEBUG" }
            flags { "Symbols" }
            targetdir "bin/debug"
+           prebuildcommands { "bin/debug/crust-packer ../data bin/debug/crust.pack" }
+
+        configuration "release"
+           defines { "NDEBUG" }
+           flags { "Optimize" }
+           targetdir "bin/release"
+           prebuildcommands { "bin/release/crust-packer ../data bin/release/crust.pack" }
+
+        configuration "macosx"
+           links { "OpenGL.framework" }
+
+    project "crust-headless"
+        kind "ConsoleApp"
+        language "C++"
+        files { "../src/**.hpp", "../src/**.cpp" }
+        includedirs {
+            "../src",
+            "../src/**",
+            "../ext/Box2D/include",
+            "../ext/SDL/include"
+        }
+        libdirs { "../ext/Box2D/lib", "../ext/SDL/lib" }
+        -- The packer is not a library, so this only makes it build first.
+        links { "Box2D", "SDL", "crust-packer" }
+        defines { "GL_GLEXT_PROTOTYPES", "CRUST_HEADLESS" }
+
+        configuration "debug"
+           defines { "DEBUG" }
+           flags { "Symbols" }
+           targetdir "bin/debug"
+           prebuildcommands { "bin/debug/crust-packer ../data bin/debug/crust.pack" }
 
         configuration "release"
            defines { "NDEBUG" }
            flags { "Optimize" }
            targetdir "bin/release"
+           prebuildcommands { "bin/release/crust-packer ../data bin/release/crust.pack" }
 
         configuration "macosx"
            links { "OpenGL.framework" }
@@ -1,11 +1,22 @@
 #define PI 3.14159265358979323846264
 
+// Direction toward the light in screen space, and how strongly the normals
+// shade the colors.
+#define LIGHT_DIRECTION vec3(-0.4, 0.6, 0.7)
+#define LIGHT_STRENGTH 0.6
+
 uniform sampler2D colorTexture;
 uniform sampler2D normalAndShadowTexture;
-uniform vec2 textureSize;
 uniform float smoothDistance;
 
 varying vec2 texCoord;
+varying vec4 atlasRect;
+varying vec2 textureSize;
+
+vec2 getAtlasCoord(vec2 spriteCoord)
+{
+    return atlasRect.xy + spriteCoord * atlasRect.zw;
+}
 
 void main()
 {
@@ -15,12 +26,21 @@ void main()
     vec2 edgeDistance = 0.5 - abs(centerOffset);
     vec2 smoothOffset = 0.5 * sign(centerOffset) * (1.0 - clamp(edgeDistance / smoothDistance, 0.0, 1.0));
     vec2 smoothPosition = nearestPosition + smoothOffset;
-    vec4 color = texture2D(colorTexture, smoothPosition / textureSize);
+    vec4 color = texture2D(colorTexture, getAtlasCoord(smoothPosition / textureSize));
 
-    vec4 normalAndShadow = texture2D(normalAndShadowTexture, texCoord - 0.25 / textureSize);
-    vec3 normal = normalAndShadow.xyz;
+    vec4 normalAndShadow = texture2D(normalAndShadowTexture, getAtlasCoord(texCoord - 0.25 / textureSize));
+    vec2 slope = (normalAndShadow.xy * 127.5 - 64.5) / 63.0;
+    vec3 normal = normalize(vec3(slope, normalAndShadow.z));
     float shadow = normalAndShadow.w;
 
-    gl_FragColor.rgb = color.rgb;
+    // Rotate the light into texture space using the screen-space
+    // derivatives of the texel position, so that it stays put as the
+    // sprite turns. A flat normal leaves the color unchanged.
+    vec3 light = normalize(LIGHT_DIRECTION);
+    vec2 lightXY = dFdx(linearPosition) * light.x + dFdy(linearPosition) * light.y;
+    light.xy = normalize(lightXY) * length(light.xy);
+    float shade = 1.0 + LIGHT_STRENGTH * (dot(normal, light) - light.z);
+
+    gl_FragColor.rgb = clamp(shade, 0.0, 2.0) * color.rgb;
     gl_FragColor.a = color.a + shadow * (1.0 - color.a);
 }
@@ -1,4 +1,9 @@
+attribute vec4 spriteAtlasRect;
+attribute vec2 spriteTextureSize;
+
 varying vec2 texCoord;
+varying vec4 atlasRect;
+varying vec2 textureSize;
 
 void main()
 {
@@ -7,4 +12,8 @@ void main()
  
     // Passing The Texture Coordinate Of Texture Unit 0 To The Fragment Shader
     texCoord = vec2(gl_MultiTexCoord0);
+
+    // Offset and size of the sprite texture in its atlas page
+    atlasRect = spriteAtlasRect;
+    textureSize = spriteTextureSize;
 }
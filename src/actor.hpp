@@ -1,10 +1,12 @@
 #ifndef CRUST_ACTOR_HPP
 #define CRUST_ACTOR_HPP
 
+#include "actor_handle.hpp"
+#include "component.hpp"
+
 #include <memory>
 
 namespace crust {
-    class Component;
     class Game;
     
     class Actor {
@@ -21,6 +23,16 @@ namespace crust {
         {
             return game_;
         }
+
+        ActorHandle const &getHandle() const
+        {
+            return handle_;
+        }
+
+        void setHandle(ActorHandle const &handle)
+        {
+            handle_ = handle;
+        }
         
         Component *getPhysicsComponent()
         {
@@ -33,6 +45,12 @@ namespace crust {
         }
         
         void setPhysicsComponent(std::auto_ptr<Component> component);
+
+        bool isBlock() const
+        {
+            return (physicsComponent_.get() &&
+                    physicsComponent_->getType() == Component::BLOCK_PHYSICS_TYPE);
+        }
         
         Component *getControlComponent()
         {
@@ -63,6 +81,7 @@ namespace crust {
         
     private:
         Game *game_;
+        ActorHandle handle_;
         
         std::auto_ptr<Component> physicsComponent_;
         std::auto_ptr<Component> controlComponent_;
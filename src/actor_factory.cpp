@@ -4,6 +4,7 @@
 #include "block_graphics_component.hpp"
 #include "block_physics_component.hpp"
 #include "component.hpp"
+#include "game.hpp"
 #include "monster_control_component.hpp"
 #include "monster_graphics_component.hpp"
 #include "monster_physics_component.hpp"
@@ -17,7 +18,19 @@ namespace crust {
     {
         std::auto_ptr<Actor> actor(new Actor(game_));
         actor->setPhysicsComponent(std::auto_ptr<Component>(new BlockPhysicsComponent(actor.get(), polygon)));
-        actor->setGraphicsComponent(std::auto_ptr<Component>(new BlockGraphicsComponent(actor.get())));
+        if (game_->getGraphicsManager()) {
+            actor->setGraphicsComponent(std::auto_ptr<Component>(new BlockGraphicsComponent(actor.get())));
+        }
+        return actor;
+    }
+
+    std::auto_ptr<Actor> ActorFactory::createBlock(BlockState const &state)
+    {
+        std::auto_ptr<Actor> actor(new Actor(game_));
+        actor->setPhysicsComponent(std::auto_ptr<Component>(new BlockPhysicsComponent(actor.get(), state)));
+        if (game_->getGraphicsManager()) {
+            actor->setGraphicsComponent(std::auto_ptr<Component>(new BlockGraphicsComponent(actor.get(), &state)));
+        }
         return actor;
     }
 
@@ -26,7 +39,9 @@ namespace crust {
         std::auto_ptr<Actor> actor(new Actor(game_));
         actor->setPhysicsComponent(std::auto_ptr<Component>(new MonsterPhysicsComponent(actor.get(), position)));
         actor->setControlComponent(std::auto_ptr<Component>(new MonsterControlComponent(actor.get())));
-        actor->setGraphicsComponent(std::auto_ptr<Component>(new MonsterGraphicsComponent(actor.get())));
+        if (game_->getGraphicsManager()) {
+            actor->setGraphicsComponent(std::auto_ptr<Component>(new MonsterGraphicsComponent(actor.get())));
+        }
         return actor;
     }
 }
@@ -5,6 +5,7 @@
 
 namespace crust {
     class Actor;
+    class BlockState;
     class Game;
     class Polygon2;
     class Vector2;
@@ -14,6 +15,7 @@ namespace crust {
         explicit ActorFactory(Game *game);
 
         std::auto_ptr<Actor> createBlock(Polygon2 const &polygon);
+        std::auto_ptr<Actor> createBlock(BlockState const &state);
         std::auto_ptr<Actor> createMonster(Vector2 const &position);
 
     private:
@@ -0,0 +1,39 @@
+#ifndef CRUST_ACTOR_HANDLE_HPP
+#define CRUST_ACTOR_HANDLE_HPP
+
+namespace crust {
+    // Weak reference to an actor in an actor store. The generation makes
+    // handles to removed actors stale, even if their slot is reused.
+    class ActorHandle {
+    public:
+        int index;
+        int generation;
+
+        ActorHandle() :
+            index(-1),
+            generation(0)
+        { }
+
+        ActorHandle(int index, int generation) :
+            index(index),
+            generation(generation)
+        { }
+
+        bool isNull() const
+        {
+            return index == -1;
+        }
+    };
+
+    inline bool operator==(ActorHandle const &h1, ActorHandle const &h2)
+    {
+        return h1.index == h2.index && h1.generation == h2.generation;
+    }
+
+    inline bool operator!=(ActorHandle const &h1, ActorHandle const &h2)
+    {
+        return !(h1 == h2);
+    }
+}
+
+#endif
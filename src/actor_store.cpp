@@ -0,0 +1,83 @@
+#include "actor_store.hpp"
+
+#include "actor.hpp"
+
+namespace crust {
+    ActorStore::ActorStore()
+    { }
+
+    ActorStore::~ActorStore()
+    {
+        for (std::size_t i = 0; i < actors_.size(); ++i) {
+            delete actors_[i];
+        }
+    }
+
+    Actor *ActorStore::get(ActorHandle const &handle)
+    {
+        int index = findActorIndex(handle);
+        return (index != -1) ? actors_[index] : 0;
+    }
+
+    Actor const *ActorStore::get(ActorHandle const &handle) const
+    {
+        int index = findActorIndex(handle);
+        return (index != -1) ? actors_[index] : 0;
+    }
+
+    ActorHandle ActorStore::add(std::auto_ptr<Actor> actor)
+    {
+        int slotIndex = 0;
+        if (freeSlots_.empty()) {
+            slotIndex = int(slots_.size());
+            slots_.push_back(Slot());
+        } else {
+            slotIndex = freeSlots_.back();
+            freeSlots_.pop_back();
+        }
+        actors_.reserve(actors_.size() + 1);
+        actorSlots_.reserve(actorSlots_.size() + 1);
+
+        Slot &slot = slots_[slotIndex];
+        slot.actorIndex = int(actors_.size());
+        ActorHandle handle(slotIndex, slot.generation);
+        actor->setHandle(handle);
+        actors_.push_back(actor.release());
+        actorSlots_.push_back(slotIndex);
+        return handle;
+    }
+
+    std::auto_ptr<Actor> ActorStore::remove(ActorHandle const &handle)
+    {
+        int index = findActorIndex(handle);
+        if (index == -1) {
+            return std::auto_ptr<Actor>();
+        }
+        std::auto_ptr<Actor> actor(actors_[index]);
+        actor->setHandle(ActorHandle());
+
+        // Move the last actor into the hole.
+        int lastIndex = int(actors_.size()) - 1;
+        actors_[index] = actors_[lastIndex];
+        actorSlots_[index] = actorSlots_[lastIndex];
+        slots_[actorSlots_[index]].actorIndex = index;
+        actors_.pop_back();
+        actorSlots_.pop_back();
+
+        // Bump the generation so that old handles to the slot go stale.
+        Slot &slot = slots_[handle.index];
+        slot.actorIndex = -1;
+        ++slot.generation;
+        freeSlots_.push_back(handle.index);
+        return actor;
+    }
+
+    int ActorStore::findActorIndex(ActorHandle const &handle) const
+    {
+        if (handle.index < 0 || int(slots_.size()) <= handle.index) {
+            return -1;
+        }
+        Slot const &slot = slots_[handle.index];
+        return (slot.generation == handle.generation) ? slot.actorIndex : -1;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef CRUST_ACTOR_STORE_HPP
+#define CRUST_ACTOR_STORE_HPP
+
+#include "actor_handle.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace crust {
+    class Actor;
+
+    // Slot map of actors. Adding, removing and looking up actors by handle
+    // are constant time operations, and the actors are kept in a dense
+    // array for iteration. Removal swaps the last actor into the hole, so
+    // dense indices are not stable across removals.
+    class ActorStore {
+    public:
+        ActorStore();
+        ~ActorStore();
+
+        bool isEmpty() const
+        {
+            return actors_.empty();
+        }
+
+        int getSize() const
+        {
+            return int(actors_.size());
+        }
+
+        Actor *getActor(int index)
+        {
+            return actors_[index];
+        }
+
+        Actor const *getActor(int index) const
+        {
+            return actors_[index];
+        }
+
+        Actor *get(ActorHandle const &handle);
+        Actor const *get(ActorHandle const &handle) const;
+
+        ActorHandle add(std::auto_ptr<Actor> actor);
+        std::auto_ptr<Actor> remove(ActorHandle const &handle);
+
+    private:
+        class Slot {
+        public:
+            int actorIndex;
+            int generation;
+
+            Slot() :
+                actorIndex(-1),
+                generation(0)
+            { }
+        };
+
+        std::vector<Slot> slots_;
+        std::vector<int> freeSlots_;
+        std::vector<Actor *> actors_;
+        std::vector<int> actorSlots_;
+
+        int findActorIndex(ActorHandle const &handle) const;
+
+        // Noncopyable.
+        ActorStore(ActorStore const &other);
+        ActorStore &operator=(ActorStore const &other);
+    };
+}
+
+#endif
@@ -0,0 +1,164 @@
+#include "asset_pack.hpp"
+
+#include "error.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace crust {
+    AssetPack::AssetPack() :
+        data_(0),
+        size_(0)
+    { }
+
+    AssetPack::~AssetPack()
+    {
+        close();
+    }
+
+    void AssetPack::open(char const *path)
+    {
+        close();
+        path_ = path;
+        map();
+        try {
+            validate();
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    void AssetPack::close()
+    {
+#ifndef _WIN32
+        if (data_ && buffer_.empty()) {
+            munmap(const_cast<char *>(data_), size_);
+        }
+#endif
+        std::vector<char>().swap(buffer_);
+        data_ = 0;
+        size_ = 0;
+    }
+
+    bool AssetPack::hasAsset(char const *name) const
+    {
+        return findEntry(name) != 0;
+    }
+
+    Asset AssetPack::getAsset(char const *name) const
+    {
+        Entry const *entry = findEntry(name);
+        if (entry == 0) {
+            std::stringstream message;
+            message << "Missing asset in pack " << path_ << ": " << name;
+            throw Error(message.str());
+        }
+        return Asset(data_ + entry->offset, entry->size);
+    }
+
+#ifndef _WIN32
+    void AssetPack::map()
+    {
+        int file = ::open(path_.c_str(), O_RDONLY);
+        if (file == -1) {
+            std::stringstream message;
+            message << "Failed to open asset pack: " << path_;
+            throw Error(message.str());
+        }
+        struct stat status;
+        void *data = MAP_FAILED;
+        if (fstat(file, &status) == 0 && status.st_size > 0) {
+            data = mmap(0, std::size_t(status.st_size), PROT_READ, MAP_PRIVATE,
+                        file, 0);
+        }
+        ::close(file);
+        if (data == MAP_FAILED) {
+            std::stringstream message;
+            message << "Failed to map asset pack: " << path_;
+            throw Error(message.str());
+        }
+        data_ = static_cast<char const *>(data);
+        size_ = std::size_t(status.st_size);
+    }
+#else
+    // No mmap, so read the whole file instead.
+    void AssetPack::map()
+    {
+        std::ifstream in(path_.c_str(), std::ios::binary);
+        if (!in.is_open()) {
+            std::stringstream message;
+            message << "Failed to open asset pack: " << path_;
+            throw Error(message.str());
+        }
+        buffer_.assign(std::istreambuf_iterator<char>(in),
+                       std::istreambuf_iterator<char>());
+        if (buffer_.empty()) {
+            std::stringstream message;
+            message << "Failed to read asset pack: " << path_;
+            throw Error(message.str());
+        }
+        data_ = &buffer_.front();
+        size_ = buffer_.size();
+    }
+#endif
+
+    void AssetPack::validate()
+    {
+        Header const *header = reinterpret_cast<Header const *>(data_);
+        if (size_ < sizeof(Header) ||
+            std::memcmp(header->magic, getMagic(), 4) != 0)
+        {
+            std::stringstream message;
+            message << "Not an asset pack: " << path_;
+            throw Error(message.str());
+        }
+        if (header->version != VERSION) {
+            std::stringstream message;
+            message << "Unsupported asset pack version " << header->version
+                    << ": " << path_;
+            throw Error(message.str());
+        }
+        std::size_t tableSize = sizeof(Header) + header->entryCount * sizeof(Entry);
+        if (size_ < tableSize) {
+            std::stringstream message;
+            message << "Truncated asset pack: " << path_;
+            throw Error(message.str());
+        }
+        Entry const *entries = reinterpret_cast<Entry const *>(header + 1);
+        for (boost::uint32_t i = 0; i < header->entryCount; ++i) {
+            Entry const &entry = entries[i];
+            if (entry.name[NAME_SIZE - 1] != 0 || entry.offset < tableSize ||
+                size_ < entry.offset || size_ - entry.offset < entry.size)
+            {
+                std::stringstream message;
+                message << "Corrupt asset pack: " << path_;
+                throw Error(message.str());
+            }
+        }
+    }
+
+    AssetPack::Entry const *AssetPack::findEntry(char const *name) const
+    {
+        if (data_ == 0) {
+            return 0;
+        }
+        Header const *header = reinterpret_cast<Header const *>(data_);
+        Entry const *entries = reinterpret_cast<Entry const *>(header + 1);
+        for (boost::uint32_t i = 0; i < header->entryCount; ++i) {
+            if (std::strcmp(entries[i].name, name) == 0) {
+                return &entries[i];
+            }
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef CRUST_ASSET_PACK_HPP
+#define CRUST_ASSET_PACK_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace crust {
+    // Bytes of an asset inside a pack. Only valid while the pack is open.
+    class Asset {
+    public:
+        char const *data;
+        std::size_t size;
+
+        Asset() :
+            data(0),
+            size(0)
+        { }
+
+        Asset(char const *data, std::size_t size) :
+            data(data),
+            size(size)
+        { }
+    };
+
+    // Read-only pack of game assets, written offline by crust-packer and
+    // memory-mapped at startup. The file starts with a header and a table
+    // of entries, followed by the assets, each aligned to eight bytes.
+    // Integers are stored little-endian, and are read in place.
+    class AssetPack {
+    public:
+        enum {
+            VERSION = 1,
+            NAME_SIZE = 32,
+            ALIGNMENT = 8
+        };
+
+        class Header {
+        public:
+            char magic[4];
+            boost::uint32_t version;
+            boost::uint32_t entryCount;
+            boost::uint32_t reserved;
+        };
+
+        class Entry {
+        public:
+            char name[NAME_SIZE];
+            boost::uint32_t offset;
+            boost::uint32_t size;
+        };
+
+        static char const *getMagic()
+        {
+            return "CRPK";
+        }
+
+        AssetPack();
+        ~AssetPack();
+
+        void open(char const *path);
+        void close();
+
+        bool hasAsset(char const *name) const;
+        Asset getAsset(char const *name) const;
+
+    private:
+        std::string path_;
+        char const *data_;
+        std::size_t size_;
+        std::vector<char> buffer_;
+
+        // Noncopyable.
+        AssetPack(AssetPack const &other);
+        AssetPack &operator=(AssetPack const &other);
+
+        void map();
+        void validate();
+        Entry const *findEntry(char const *name) const;
+    };
+}
+
+#endif
@@ -0,0 +1,258 @@
+#include "bit_grid.hpp"
+
+#include <algorithm>
+
+namespace crust {
+    namespace {
+        typedef BitGrid::Word Word;
+
+        // The word must not be zero.
+        int findLowestBit(Word word)
+        {
+#ifdef __GNUC__
+            return __builtin_ctzll(word);
+#else
+            int bit = 0;
+            for (; !(word & 1); word >>= 1) {
+                ++bit;
+            }
+            return bit;
+#endif
+        }
+
+        // Bits from low to high, inclusive.
+        Word getMask(int low, int high)
+        {
+            return (~Word(0) << low) & (~Word(0) >> (63 - high));
+        }
+    }
+
+    BitGrid::BitGrid() :
+        wordX_(0),
+        y_(0),
+        wordWidth_(0),
+        height_(0)
+    { }
+
+    void BitGrid::setElement(int x, int y, bool value)
+    {
+        Word bit = Word(1) << (x & (WORD_BITS - 1));
+        if (value) {
+            reserve(x, y, x, y);
+            Word &word = words_[(y - y_) * wordWidth_ + (x >> 6) - wordX_];
+            if (!(word & bit)) {
+                word |= bit;
+                counter_.addCell(x, y);
+            }
+        } else {
+            Word *word = findWord(x, y);
+            if (word && (*word & bit)) {
+                *word &= ~bit;
+                counter_.removeCell(x, y);
+            }
+        }
+    }
+
+    void BitGrid::setSpan(int y, int x1, int x2)
+    {
+        if (x2 < x1) {
+            return;
+        }
+        reserve(x1, y, x2, y);
+        Word *row = &words_[(y - y_) * wordWidth_];
+        int wordX1 = x1 >> 6;
+        int wordX2 = x2 >> 6;
+        for (int wordX = wordX1; wordX <= wordX2; ++wordX) {
+            int low = (wordX == wordX1) ? (x1 & 63) : 0;
+            int high = (wordX == wordX2) ? (x2 & 63) : 63;
+            Word &word = row[wordX - wordX_];
+            Word bits = getMask(low, high) & ~word;
+            word |= bits;
+            addBits(wordX, y, bits);
+        }
+    }
+
+    BitGrid::Word BitGrid::getBits(int x, int y, int count) const
+    {
+        int wordX = x >> 6;
+        int bit = x & 63;
+        Word bits = getWord(wordX, y) >> bit;
+        if (bit) {
+            bits |= getWord(wordX + 1, y) << (WORD_BITS - bit);
+        }
+        if (count < WORD_BITS) {
+            bits &= (Word(1) << count) - 1;
+        }
+        return bits;
+    }
+
+    bool BitGrid::isCrossSet(int x, int y) const
+    {
+        return (getBits(x - 1, y, 3) || getElement(x, y - 1) ||
+                getElement(x, y + 1));
+    }
+
+    bool BitGrid::findFirstInRow(int y, int x, int *result) const
+    {
+        int wordX = x >> 6;
+        Word word = getWord(wordX, y) & (~Word(0) << (x & 63));
+        if (wordX < wordX_) {
+            wordX = wordX_;
+            word = getWord(wordX, y);
+        }
+        while (wordX < wordX_ + wordWidth_) {
+            if (word) {
+                *result = wordX * WORD_BITS + findLowestBit(word);
+                return true;
+            }
+            ++wordX;
+            word = getWord(wordX, y);
+        }
+        return false;
+    }
+
+    bool BitGrid::findFirst(IntVector2 *result) const
+    {
+        for (int row = 0; row < height_; ++row) {
+            for (int i = 0; i < wordWidth_; ++i) {
+                Word word = words_[row * wordWidth_ + i];
+                if (word) {
+                    result->x = (wordX_ + i) * WORD_BITS + findLowestBit(word);
+                    result->y = y_ + row;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void BitGrid::merge(BitGrid const &other)
+    {
+        if (other.isEmpty()) {
+            return;
+        }
+        IntBox2 const &box = other.counter_.getBounds();
+        reserve(box.p1.x, box.p1.y, box.p2.x - 1, box.p2.y - 1);
+        for (int y = box.p1.y; y < box.p2.y; ++y) {
+            Word *row = &words_[(y - y_) * wordWidth_];
+            for (int wordX = box.p1.x >> 6; wordX <= (box.p2.x - 1) >> 6; ++wordX) {
+                Word &word = row[wordX - wordX_];
+                Word bits = other.getWord(wordX, y) & ~word;
+                word |= bits;
+                addBits(wordX, y, bits);
+            }
+        }
+    }
+
+    void BitGrid::intersect(BitGrid const &other)
+    {
+        for (int row = 0; row < height_; ++row) {
+            for (int i = 0; i < wordWidth_; ++i) {
+                Word &word = words_[row * wordWidth_ + i];
+                Word bits = word & ~other.getWord(wordX_ + i, y_ + row);
+                word &= ~bits;
+                removeBits(wordX_ + i, y_ + row, bits);
+            }
+        }
+    }
+
+    bool BitGrid::intersects(BitGrid const &other) const
+    {
+        for (int row = 0; row < height_; ++row) {
+            for (int i = 0; i < wordWidth_; ++i) {
+                if (words_[row * wordWidth_ + i] &
+                    other.getWord(wordX_ + i, y_ + row))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void BitGrid::clear()
+    {
+        counter_.clear();
+        wordX_ = 0;
+        y_ = 0;
+        wordWidth_ = 0;
+        height_ = 0;
+        words_.clear();
+    }
+
+    void BitGrid::swap(BitGrid &other)
+    {
+        counter_.swap(other.counter_);
+        std::swap(wordX_, other.wordX_);
+        std::swap(y_, other.y_);
+        std::swap(wordWidth_, other.wordWidth_);
+        std::swap(height_, other.height_);
+        words_.swap(other.words_);
+    }
+
+    // Grows by half the size in each direction that needs to grow, so that
+    // setting cells one at a time takes amortized constant time.
+    void BitGrid::reserve(int x1, int y1, int x2, int y2)
+    {
+        int wordX1 = x1 >> 6;
+        int wordX2 = x2 >> 6;
+        int oldWordX2 = wordX_ + wordWidth_ - 1;
+        int oldY2 = y_ + height_ - 1;
+        if (!words_.empty() && wordX_ <= wordX1 && wordX2 <= oldWordX2 &&
+            y_ <= y1 && y2 <= oldY2)
+        {
+            return;
+        }
+
+        if (!words_.empty()) {
+            wordX1 = std::min(wordX1, wordX_);
+            wordX2 = std::max(wordX2, oldWordX2);
+            y1 = std::min(y1, y_);
+            y2 = std::max(y2, oldY2);
+
+            int wordSlack = (wordX2 - wordX1 + 1) / 2;
+            int rowSlack = (y2 - y1 + 1) / 2;
+            if (wordX1 < wordX_) {
+                wordX1 -= wordSlack;
+            }
+            if (oldWordX2 < wordX2) {
+                wordX2 += wordSlack;
+            }
+            if (y1 < y_) {
+                y1 -= rowSlack;
+            }
+            if (oldY2 < y2) {
+                y2 += rowSlack;
+            }
+        }
+
+        int wordWidth = wordX2 - wordX1 + 1;
+        int height = y2 - y1 + 1;
+        std::vector<Word> words(wordWidth * height, 0);
+        for (int row = 0; row < height_; ++row) {
+            std::copy(words_.begin() + row * wordWidth_,
+                      words_.begin() + (row + 1) * wordWidth_,
+                      words.begin() + ((y_ + row - y1) * wordWidth +
+                                       wordX_ - wordX1));
+        }
+        wordX_ = wordX1;
+        y_ = y1;
+        wordWidth_ = wordWidth;
+        height_ = height;
+        words_.swap(words);
+    }
+
+    void BitGrid::addBits(int wordX, int y, Word bits)
+    {
+        for (; bits; bits &= bits - 1) {
+            counter_.addCell(wordX * WORD_BITS + findLowestBit(bits), y);
+        }
+    }
+
+    void BitGrid::removeBits(int wordX, int y, Word bits)
+    {
+        for (; bits; bits &= bits - 1) {
+            counter_.removeCell(wordX * WORD_BITS + findLowestBit(bits), y);
+        }
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef CRUST_BIT_GRID_HPP
+#define CRUST_BIT_GRID_HPP
+
+#include "int_geometry.hpp"
+#include "occupancy_counter.hpp"
+
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace crust {
+    // Grid of booleans, packed 64 cells to a word along each row. The
+    // words are aligned to multiples of 64 in grid coordinates, so whole
+    // words line up between any two bit grids. The bounds are always tight.
+    class BitGrid {
+    public:
+        typedef boost::uint64_t Word;
+
+        enum {
+            WORD_BITS = 64
+        };
+
+        BitGrid();
+
+        int getX() const
+        {
+            return counter_.getBounds().p1.x;
+        }
+
+        int getY() const
+        {
+            return counter_.getBounds().p1.y;
+        }
+
+        int getWidth() const
+        {
+            return counter_.getBounds().getWidth();
+        }
+
+        int getHeight() const
+        {
+            return counter_.getBounds().getHeight();
+        }
+
+        bool isEmpty() const
+        {
+            return counter_.getCount() == 0;
+        }
+
+        int getCount() const
+        {
+            return counter_.getCount();
+        }
+
+        int getRowCount(int y) const
+        {
+            return counter_.getRowCount(y);
+        }
+
+        bool getElement(int x, int y) const
+        {
+            Word const *word = findWord(x, y);
+            return word && (*word >> (x & (WORD_BITS - 1)) & 1);
+        }
+
+        void setElement(int x, int y, bool value);
+
+        // Sets the cells from x1 to x2, inclusive.
+        void setSpan(int y, int x1, int x2);
+
+        // Returns the count cells starting at x, in the low bits. The count
+        // is at most 64.
+        Word getBits(int x, int y, int count) const;
+
+        // True if the cell or any of its four neighbors is set.
+        bool isCrossSet(int x, int y) const;
+
+        // Finds the first set cell at or after x in the row.
+        bool findFirstInRow(int y, int x, int *result) const;
+
+        // Finds the first set cell in row-major order.
+        bool findFirst(IntVector2 *result) const;
+
+        void merge(BitGrid const &other);
+        void intersect(BitGrid const &other);
+        bool intersects(BitGrid const &other) const;
+
+        void clear();
+        void swap(BitGrid &other);
+
+    private:
+        OccupancyCounter counter_;
+
+        // Allocated rows and word columns.
+        int wordX_;
+        int y_;
+        int wordWidth_;
+        int height_;
+        std::vector<Word> words_;
+
+        Word const *findWord(int x, int y) const
+        {
+            return const_cast<BitGrid *>(this)->findWord(x, y);
+        }
+
+        Word *findWord(int x, int y)
+        {
+            int wordX = (x >> 6) - wordX_;
+            int row = y - y_;
+            if (0 <= wordX && wordX < wordWidth_ && 0 <= row && row < height_) {
+                return &words_[row * wordWidth_ + wordX];
+            } else {
+                return 0;
+            }
+        }
+
+        Word getWord(int wordX, int y) const
+        {
+            wordX -= wordX_;
+            int row = y - y_;
+            if (0 <= wordX && wordX < wordWidth_ && 0 <= row && row < height_) {
+                return words_[row * wordWidth_ + wordX];
+            } else {
+                return 0;
+            }
+        }
+
+        void reserve(int x1, int y1, int x2, int y2);
+
+        // Updates the counter for bits that have just been set or cleared.
+        void addBits(int wordX, int y, Word bits);
+        void removeBits(int wordX, int y, Word bits);
+    };
+}
+
+#endif
@@ -0,0 +1,481 @@
+#include "chunk_manager.hpp"
+
+#include "actor.hpp"
+#include "actor_factory.hpp"
+#include "block_graphics_component.hpp"
+#include "block_physics_component.hpp"
+#include "color_generator.hpp"
+#include "delauney_triangulation.hpp"
+#include "dungeon_generator.hpp"
+#include "error.hpp"
+#include "game.hpp"
+#include "physics_manager.hpp"
+#include "random.hpp"
+#include "tracer.hpp"
+#include "voronoi_diagram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace crust {
+    ChunkManager::ChunkManager(Game *game, Random::Seed seed, int loadRadius,
+                               int threadCount, int commitCount) :
+        game_(game),
+        seed_(seed),
+        chunkSize_(16.0f),
+        siteCount_(12),
+        sitePadding_(3),
+        loadRadius_(loadRadius),
+        evictRadius_(loadRadius + 1),
+        commitCount_(std::max(commitCount, 1)),
+        pendingChunkCount_(0),
+        mutex_(0),
+        condition_(0),
+        quitting_(false)
+    {
+        mutex_ = SDL_CreateMutex();
+        condition_ = SDL_CreateCond();
+        for (int i = 0; i < threadCount; ++i) {
+            SDL_Thread *thread = SDL_CreateThread(&runWorker, "chunks", this);
+            if (thread == 0) {
+                std::stringstream message;
+                message << "Failed to create chunk thread: " << SDL_GetError();
+                stopWorkers();
+                SDL_DestroyCond(condition_);
+                SDL_DestroyMutex(mutex_);
+                throw Error(message.str());
+            }
+            threads_.push_back(thread);
+        }
+    }
+
+    ChunkManager::~ChunkManager()
+    {
+        stopWorkers();
+        SDL_DestroyCond(condition_);
+        SDL_DestroyMutex(mutex_);
+    }
+
+    IntVector2 ChunkManager::getChunkCoords(Vector2 const &position) const
+    {
+        return IntVector2(int(std::floor(position.x / chunkSize_)),
+                          int(std::floor(position.y / chunkSize_)));
+    }
+
+    Box2 ChunkManager::getChunkBox(IntVector2 const &coords) const
+    {
+        return Box2(Vector2(float(coords.x) * chunkSize_,
+                            float(coords.y) * chunkSize_),
+                    Vector2(float(coords.x + 1) * chunkSize_,
+                            float(coords.y + 1) * chunkSize_));
+    }
+
+    void ChunkManager::update(Vector2 const &position)
+    {
+        saveStrayBlocks();
+
+        IntVector2 center = getChunkCoords(position);
+        evictedChunks_.clear();
+        for (ChunkMap::iterator i = chunks_.begin(); i != chunks_.end(); ++i) {
+            IntVector2 const &coords = i->first;
+            if (evictRadius_ < std::abs(coords.x - center.x) ||
+                evictRadius_ < std::abs(coords.y - center.y))
+            {
+                evictedChunks_.push_back(coords);
+            }
+        }
+        for (std::size_t i = 0; i < evictedChunks_.size(); ++i) {
+            evictChunk(evictedChunks_[i]);
+        }
+
+        // Request the nearest chunks first.
+        for (int radius = 0; radius <= loadRadius_; ++radius) {
+            for (int dy = -radius; dy <= radius; ++dy) {
+                for (int dx = -radius; dx <= radius; ++dx) {
+                    if (std::abs(dx) == radius || std::abs(dy) == radius) {
+                        loadChunk(IntVector2(center.x + dx, center.y + dy));
+                    }
+                }
+            }
+        }
+
+        receiveChunks();
+        commitChunks();
+    }
+
+    void ChunkManager::loadChunk(IntVector2 const &coords)
+    {
+        if (isChunkLoaded(coords)) {
+            return;
+        }
+
+        chunks_[coords];
+        ++pendingChunkCount_;
+        if (threads_.empty()) {
+            std::auto_ptr<ChunkData> data(new ChunkData(coords));
+            generateChunk(data.get());
+            acceptChunk(data);
+        } else {
+            SDL_LockMutex(mutex_);
+            requests_.push_back(coords);
+            SDL_CondSignal(condition_);
+            SDL_UnlockMutex(mutex_);
+        }
+    }
+
+    // Only what differs from the generated chunk is saved: the modified
+    // blocks, and the indices of the generated blocks that are gone. The
+    // unmodified blocks are generated again when the chunk is loaded.
+    void ChunkManager::evictChunk(IntVector2 const &coords)
+    {
+        ChunkMap::iterator chunk = chunks_.find(coords);
+        if (chunk == chunks_.end()) {
+            return;
+        }
+        ChunkState state = chunk->second.state;
+
+        blockComponents_.clear();
+        game_->getPhysicsManager()->findBlockComponents(getChunkBox(coords),
+                                                        &blockComponents_);
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < blockComponents_.size(); ++i) {
+            b2Vec2 position = blockComponents_[i]->getBody()->GetPosition();
+            if (getChunkCoords(Vector2(position.x, position.y)) == coords) {
+                blockComponents_[count++] = blockComponents_[i];
+            }
+        }
+        blockComponents_.resize(count);
+
+        // Blocks that have not been committed yet.
+        ChunkDataDeque::iterator data = committingChunks_.begin();
+        while (data != committingChunks_.end() && data->coords != coords) {
+            ++data;
+        }
+        std::vector<BlockState> uncommittedStates;
+        if (data != committingChunks_.end()) {
+            uncommittedStates.assign(data->blockStates.begin() + chunk->second.blockCount,
+                                     data->blockStates.end());
+            committingChunks_.erase(data);
+        }
+
+        if (state == GENERATING_STATE) {
+            // Anything here strayed in while the chunk was generating. The
+            // saved chunk, if any, has not been applied yet.
+            if (!blockComponents_.empty()) {
+                SavedChunk &savedChunk = savedChunks_[coords];
+                for (std::size_t i = 0; i < blockComponents_.size(); ++i) {
+                    saveBlock(blockComponents_[i], &savedChunk);
+                }
+            }
+
+            SDL_LockMutex(mutex_);
+            requests_.erase(std::remove(requests_.begin(), requests_.end(), coords),
+                            requests_.end());
+            SDL_UnlockMutex(mutex_);
+        } else {
+            SavedChunk &savedChunk = savedChunks_[coords];
+            int generatedBlockCount = chunk->second.generatedBlockCount;
+            keptBlocks_.assign(generatedBlockCount, false);
+            for (std::size_t i = 0; i < blockComponents_.size(); ++i) {
+                BlockPhysicsComponent *component = blockComponents_[i];
+                int index = component->getGeneratedIndex();
+                if (component->isModified() || index < 0 ||
+                    generatedBlockCount <= index)
+                {
+                    saveBlock(component, &savedChunk);
+                } else {
+                    keptBlocks_[index] = true;
+                    game_->removeActor(component->getActor());
+                }
+            }
+            for (std::size_t i = 0; i < uncommittedStates.size(); ++i) {
+                BlockState const &blockState = uncommittedStates[i];
+                int index = blockState.generatedIndex;
+                if (blockState.modified || index < 0 ||
+                    generatedBlockCount <= index)
+                {
+                    savedChunk.blockStates.push_back(blockState);
+                } else {
+                    keptBlocks_[index] = true;
+                }
+            }
+            for (int i = 0; i < generatedBlockCount; ++i) {
+                if (!keptBlocks_[i]) {
+                    savedChunk.removedBlocks.push_back(i);
+                }
+            }
+            if (savedChunk.removedBlocks.empty() &&
+                savedChunk.blockStates.empty())
+            {
+                savedChunks_.erase(coords);
+            }
+        }
+
+        if (state != LOADED_STATE) {
+            --pendingChunkCount_;
+        }
+        chunks_.erase(chunk);
+    }
+
+    bool ChunkManager::findRoomCenter(Vector2 const &position,
+                                      Vector2 *center) const
+    {
+        ChunkMap::const_iterator chunk = chunks_.find(getChunkCoords(position));
+        if (chunk == chunks_.end() || chunk->second.roomBoxes.empty()) {
+            return false;
+        }
+        *center = chunk->second.roomBoxes.front().getCenter();
+        return true;
+    }
+
+    // The sites are jittered on a global grid. The triangulation covers a
+    // few extra rows of sites around the chunk, so that the cells of the
+    // chunk come out the same as in the neighbor chunks. Each cell goes to
+    // the chunk that contains its centroid, the same rule that eviction
+    // uses for the block positions.
+    void ChunkManager::generateChunk(ChunkData *data) const
+    {
+        TraceZone zone(game_->getTracer(), "GENERATE");
+        IntVector2 const &coords = data->coords;
+        int minX = coords.x * siteCount_ - sitePadding_;
+        int minY = coords.y * siteCount_ - sitePadding_;
+        int maxX = (coords.x + 1) * siteCount_ + sitePadding_;
+        int maxY = (coords.y + 1) * siteCount_ + sitePadding_;
+        float siteSize = chunkSize_ / float(siteCount_);
+        Box2 triangulationBounds(Vector2(float(minX) * siteSize,
+                                         float(minY) * siteSize),
+                                 Vector2(float(maxX) * siteSize,
+                                         float(maxY) * siteSize));
+        triangulationBounds.pad(5.0f);
+
+        DelauneyTriangulation triangulation(triangulationBounds);
+        DelauneyTriangulation::VertexVector sites;
+        sites.reserve((maxX - minX) * (maxY - minY));
+        for (int y = minY; y < maxY; ++y) {
+            for (int x = minX; x < maxX; ++x) {
+                sites.push_back(getSite(x, y));
+            }
+        }
+        triangulation.addVertices(sites);
+        VoronoiDiagram voronoiDiagram;
+        voronoiDiagram.generate(triangulation);
+
+        Random random(getChunkSeed(coords));
+        Random dungeonRandom = random.getStream(DUNGEON_STREAM);
+        Random rotationRandom = random.getStream(ROTATION_STREAM);
+        Random colorRandom = random.getStream(COLOR_STREAM);
+
+        DungeonGenerator dungeonGenerator(&dungeonRandom, getChunkBox(coords));
+        dungeonGenerator.generate();
+        data->roomBoxes.clear();
+        for (int i = 0; i < dungeonGenerator.getRoomBoxCount(); ++i) {
+            data->roomBoxes.push_back(dungeonGenerator.getRoomBox(i));
+        }
+        data->corridorBoxes.clear();
+        for (int i = 0; i < dungeonGenerator.getCorridorBoxCount(); ++i) {
+            data->corridorBoxes.push_back(dungeonGenerator.getCorridorBox(i));
+        }
+
+        data->blockStates.clear();
+        Polygon2 polygon;
+        for (int i = 0; i < voronoiDiagram.getPolygonCount(); ++i) {
+            voronoiDiagram.getPolygon(i, &polygon);
+            if (polygon.getSize() < 3) {
+                continue;
+            }
+            Vector2 centroid = polygon.getCentroid();
+            if (getChunkCoords(centroid) != coords) {
+                continue;
+            }
+
+            // Leave the dungeon empty.
+            bool empty = false;
+            for (std::size_t j = 0; j < data->roomBoxes.size() && !empty; ++j) {
+                empty = data->roomBoxes[j].containsPoint(centroid);
+            }
+            for (std::size_t j = 0; j < data->corridorBoxes.size() && !empty; ++j) {
+                empty = data->corridorBoxes[j].containsPoint(centroid);
+            }
+            if (empty) {
+                continue;
+            }
+
+            data->blockStates.push_back(BlockState());
+            BlockState &state = data->blockStates.back();
+            float angle = -M_PI + 2.0f * M_PI * rotationRandom.getFloat();
+            BlockPhysicsComponent::initState(polygon, angle, &state);
+            state.generatedIndex = int(data->blockStates.size()) - 1;
+
+            ColorGenerator colorGenerator(&colorRandom);
+            state.gridColors.reserve(state.gridElements.size());
+            for (std::size_t j = 0; j < state.gridElements.size(); ++j) {
+                if (state.gridElements[j]) {
+                    state.gridColors.push_back(colorGenerator.generateColor());
+                } else {
+                    state.gridColors.push_back(Color3());
+                }
+            }
+        }
+    }
+
+    int ChunkManager::runWorker(void *data)
+    {
+        static_cast<ChunkManager *>(data)->work();
+        return 0;
+    }
+
+    void ChunkManager::work()
+    {
+        SDL_LockMutex(mutex_);
+        while (!quitting_) {
+            if (requests_.empty()) {
+                SDL_CondWait(condition_, mutex_);
+                continue;
+            }
+            IntVector2 coords = requests_.front();
+            requests_.pop_front();
+            SDL_UnlockMutex(mutex_);
+
+            std::auto_ptr<ChunkData> data(new ChunkData(coords));
+            generateChunk(data.get());
+
+            SDL_LockMutex(mutex_);
+            results_.push_back(data.release());
+        }
+        SDL_UnlockMutex(mutex_);
+    }
+
+    void ChunkManager::stopWorkers()
+    {
+        SDL_LockMutex(mutex_);
+        quitting_ = true;
+        SDL_CondBroadcast(condition_);
+        SDL_UnlockMutex(mutex_);
+        for (std::size_t i = 0; i < threads_.size(); ++i) {
+            SDL_WaitThread(threads_[i], 0);
+        }
+        threads_.clear();
+    }
+
+    void ChunkManager::receiveChunks()
+    {
+        ChunkDataDeque results;
+        SDL_LockMutex(mutex_);
+        results.transfer(results.end(), results_);
+        SDL_UnlockMutex(mutex_);
+        while (!results.empty()) {
+            acceptChunk(std::auto_ptr<ChunkData>(results.pop_front().release()));
+        }
+    }
+
+    // Results for chunks that have been evicted, or requested more than
+    // once, are dropped.
+    void ChunkManager::acceptChunk(std::auto_ptr<ChunkData> data)
+    {
+        ChunkMap::iterator chunk = chunks_.find(data->coords);
+        if (chunk == chunks_.end() || chunk->second.state != GENERATING_STATE) {
+            return;
+        }
+
+        chunk->second.generatedBlockCount = int(data->blockStates.size());
+        SavedChunkMap::iterator saved = savedChunks_.find(data->coords);
+        if (saved != savedChunks_.end()) {
+            std::vector<int> const &removedBlocks = saved->second.removedBlocks;
+            std::vector<BlockState> &blockStates = data->blockStates;
+            if (!removedBlocks.empty()) {
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < blockStates.size(); ++i) {
+                    if (!std::binary_search(removedBlocks.begin(),
+                                            removedBlocks.end(), int(i)))
+                    {
+                        blockStates[count++] = blockStates[i];
+                    }
+                }
+                blockStates.resize(count);
+            }
+            std::vector<BlockState> const &savedStates = saved->second.blockStates;
+            blockStates.insert(blockStates.end(), savedStates.begin(),
+                               savedStates.end());
+            savedChunks_.erase(saved);
+        }
+
+        chunk->second.state = COMMITTING_STATE;
+        chunk->second.roomBoxes = data->roomBoxes;
+        committingChunks_.push_back(data.release());
+    }
+
+    void ChunkManager::commitChunks()
+    {
+        ActorFactory *actorFactory = game_->getActorFactory();
+        int count = 0;
+        while (count < commitCount_ && !committingChunks_.empty()) {
+            ChunkData &data = committingChunks_.front();
+            Chunk &chunk = chunks_[data.coords];
+            int blockCount = int(data.blockStates.size());
+            while (count < commitCount_ && chunk.blockCount < blockCount) {
+                BlockState const &state = data.blockStates[chunk.blockCount];
+                game_->addActor(actorFactory->createBlock(state));
+                ++chunk.blockCount;
+                ++count;
+            }
+            if (chunk.blockCount == blockCount) {
+                chunk.state = LOADED_STATE;
+                --pendingChunkCount_;
+                committingChunks_.pop_front();
+            }
+        }
+    }
+
+    Vector2 ChunkManager::getSite(int x, int y) const
+    {
+        std::size_t hash = hashValue(hashValue(hashValue(std::size_t(seed_)) ^
+                                               std::size_t(x)) ^
+                                     std::size_t(y));
+        float dx = float(hash & 0xffff) / 65536.0f;
+        float dy = float((hash >> 16) & 0xffff) / 65536.0f;
+        float siteSize = chunkSize_ / float(siteCount_);
+        return Vector2((float(x) + dx) * siteSize, (float(y) + dy) * siteSize);
+    }
+
+    Random::Seed ChunkManager::getChunkSeed(IntVector2 const &coords) const
+    {
+        std::size_t hash = ChunkHash()(coords);
+        Random::Seed chunkHash = ((Random::Seed(hashValue(hash)) << 32) ^
+                                  Random::Seed(hashValue(hash + 1)));
+        return seed_ ^ chunkHash;
+    }
+
+    // Active blocks can fall or be thrown into chunks that are not loaded.
+    // Save them with the chunk, which restores them when it is loaded.
+    void ChunkManager::saveStrayBlocks()
+    {
+        PhysicsManager *physicsManager = game_->getPhysicsManager();
+        for (int i = 0; i < physicsManager->getActiveBlockComponentCount(); ++i) {
+            BlockPhysicsComponent *component = physicsManager->getActiveBlockComponent(i);
+            b2Vec2 position = component->getBody()->GetPosition();
+            IntVector2 coords = getChunkCoords(Vector2(position.x, position.y));
+            if (!isChunkLoaded(coords)) {
+                saveBlock(component, &savedChunks_[coords]);
+            }
+        }
+    }
+
+    void ChunkManager::saveBlock(BlockPhysicsComponent *component,
+                                 SavedChunk *savedChunk)
+    {
+        savedChunk->blockStates.push_back(BlockState());
+        BlockState &state = savedChunk->blockStates.back();
+        component->getState(&state);
+        state.generatedIndex = -1;
+
+        Actor *actor = component->getActor();
+        BlockGraphicsComponent *graphicsComponent =
+            componentCast<BlockGraphicsComponent>(actor->getGraphicsComponent());
+        if (graphicsComponent) {
+            graphicsComponent->getColors(&state);
+        }
+        game_->removeActor(actor);
+    }
+}
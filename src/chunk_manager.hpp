@@ -0,0 +1,196 @@
+#ifndef CRUST_CHUNK_MANAGER_HPP
+#define CRUST_CHUNK_MANAGER_HPP
+
+#include "block_state.hpp"
+#include "geometry.hpp"
+#include "hash.hpp"
+#include "int_math.hpp"
+#include "random.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <boost/ptr_container/ptr_deque.hpp>
+#include <boost/unordered_map.hpp>
+#include <SDL/SDL.h>
+
+namespace crust {
+    class BlockPhysicsComponent;
+    class Game;
+
+    // Generated content of a chunk, before any actors are created for it.
+    class ChunkData {
+    public:
+        IntVector2 coords;
+        std::vector<BlockState> blockStates;
+        std::vector<Box2> roomBoxes;
+        std::vector<Box2> corridorBoxes;
+
+        explicit ChunkData(IntVector2 const &coords) :
+            coords(coords)
+        { }
+    };
+
+    // Streams the world in square chunks around a focus position. A chunk
+    // is generated from the world seed and its coordinates only, so it
+    // comes out the same every time. Evicted chunks only keep what differs
+    // from the generated blocks, and apply it when loaded again.
+    //
+    // A block belongs to the chunk that contains its position, which is
+    // the centroid of its polygon until it is moved.
+    //
+    // Chunks are generated on worker threads, all the way to rasterized
+    // and colored block grids. The main thread only creates the actors, a
+    // bounded number of blocks per update.
+    class ChunkManager {
+    public:
+        // Without threads, chunks are generated on the calling thread.
+        ChunkManager(Game *game, Random::Seed seed, int loadRadius,
+                     int threadCount, int commitCount);
+        ~ChunkManager();
+
+        float getChunkSize() const
+        {
+            return chunkSize_;
+        }
+
+        IntVector2 getChunkCoords(Vector2 const &position) const;
+        Box2 getChunkBox(IntVector2 const &coords) const;
+
+        int getChunkCount() const
+        {
+            return int(chunks_.size());
+        }
+
+        // Chunks that are still being generated or committed.
+        int getPendingChunkCount() const
+        {
+            return pendingChunkCount_;
+        }
+
+        int getSavedChunkCount() const
+        {
+            return int(savedChunks_.size());
+        }
+
+        // True if the chunk is loaded or being loaded.
+        bool isChunkLoaded(IntVector2 const &coords) const
+        {
+            return chunks_.find(coords) != chunks_.end();
+        }
+
+        // Evicts the chunks outside the evict radius of the position,
+        // requests the chunks within the load radius, and commits
+        // generated chunks.
+        void update(Vector2 const &position);
+
+        void loadChunk(IntVector2 const &coords);
+        void evictChunk(IntVector2 const &coords);
+
+        // Finds the center of a dungeon room in the generated chunk that
+        // contains the position.
+        bool findRoomCenter(Vector2 const &position, Vector2 *center) const;
+
+        // Touches no game state, so it can run on any thread.
+        void generateChunk(ChunkData *data) const;
+
+    private:
+        enum ChunkState {
+            GENERATING_STATE,
+            COMMITTING_STATE,
+            LOADED_STATE
+        };
+
+        class Chunk {
+        public:
+            ChunkState state;
+            int blockCount;
+            int generatedBlockCount;
+            std::vector<Box2> roomBoxes;
+
+            Chunk() :
+                state(GENERATING_STATE),
+                blockCount(0),
+                generatedBlockCount(0)
+            { }
+        };
+
+        // The difference from the generated chunk.
+        class SavedChunk {
+        public:
+            // Sorted indices of the generated blocks that have been mined,
+            // moved or edited.
+            std::vector<int> removedBlocks;
+
+            // Modified blocks, added to the generated ones.
+            std::vector<BlockState> blockStates;
+        };
+
+        class ChunkHash {
+        public:
+            std::size_t operator()(IntVector2 const &coords) const
+            {
+                return hashValue(hashValue(std::size_t(coords.x)) ^
+                                 std::size_t(coords.y));
+            }
+        };
+
+        typedef boost::unordered_map<IntVector2, Chunk, ChunkHash> ChunkMap;
+        typedef boost::unordered_map<IntVector2, SavedChunk, ChunkHash> SavedChunkMap;
+        typedef boost::ptr_deque<ChunkData> ChunkDataDeque;
+        typedef std::vector<BlockPhysicsComponent *> BlockComponentVector;
+
+        Game *game_;
+        Random::Seed seed_;
+        float chunkSize_;
+        int siteCount_;
+        int sitePadding_;
+        int loadRadius_;
+        int evictRadius_;
+        int commitCount_;
+        ChunkMap chunks_;
+        int pendingChunkCount_;
+
+        // Kept in memory, and never trimmed. Grows with what the players
+        // change: an index per generated block that is mined, and a full
+        // block state per block that is moved or edited.
+        SavedChunkMap savedChunks_;
+
+        // Generated chunks waiting to be committed, oldest first.
+        ChunkDataDeque committingChunks_;
+
+        // Shared with the worker threads, and guarded by the mutex.
+        SDL_mutex *mutex_;
+        SDL_cond *condition_;
+        bool quitting_;
+        std::deque<IntVector2> requests_;
+        ChunkDataDeque results_;
+
+        std::vector<SDL_Thread *> threads_;
+
+        // Scratch state, kept between calls to avoid allocations.
+        std::vector<IntVector2> evictedChunks_;
+        BlockComponentVector blockComponents_;
+        std::vector<bool> keptBlocks_;
+
+        // Noncopyable.
+        ChunkManager(ChunkManager const &other);
+        ChunkManager &operator=(ChunkManager const &other);
+
+        static int runWorker(void *data);
+        void work();
+        void stopWorkers();
+
+        void receiveChunks();
+        void acceptChunk(std::auto_ptr<ChunkData> data);
+        void commitChunks();
+
+        Vector2 getSite(int x, int y) const;
+        Random::Seed getChunkSeed(IntVector2 const &coords) const;
+        void saveStrayBlocks();
+        void saveBlock(BlockPhysicsComponent *component,
+                       SavedChunk *savedChunk);
+    };
+}
+
+#endif
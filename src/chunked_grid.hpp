@@ -0,0 +1,188 @@
+#ifndef CRUST_CHUNKED_GRID_HPP
+#define CRUST_CHUNKED_GRID_HPP
+
+#include "hash.hpp"
+#include "int_geometry.hpp"
+#include "occupancy_counter.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <boost/ptr_container/ptr_unordered_map.hpp>
+
+namespace crust {
+    // Sparse variant of Grid that stores the elements in fixed-size tiles,
+    // allocated on first use and freed when they only hold the default
+    // value again. Growing never copies existing elements, and empty
+    // regions cost nothing. The bounds are always tight.
+    template <typename T>
+    class ChunkedGrid {
+    public:
+        typedef T Element;
+
+        enum {
+            TILE_BITS = 4,
+            TILE_SIZE = 1 << TILE_BITS,
+            TILE_MASK = TILE_SIZE - 1
+        };
+
+        explicit ChunkedGrid(Element const &defaultValue = Element()) :
+            defaultValue_(defaultValue),
+            cachedTile_(0),
+            cacheValid_(false)
+        { }
+
+        int getX() const
+        {
+            return counter_.getBounds().p1.x;
+        }
+
+        int getY() const
+        {
+            return counter_.getBounds().p1.y;
+        }
+
+        int getWidth() const
+        {
+            return counter_.getBounds().getWidth();
+        }
+
+        int getHeight() const
+        {
+            return counter_.getBounds().getHeight();
+        }
+
+        bool isEmpty() const
+        {
+            return counter_.getCount() == 0;
+        }
+
+        int getTileCount() const
+        {
+            return int(tiles_.size());
+        }
+
+        Element const &getElement(int x, int y) const
+        {
+            Tile const *tile = findTile(IntVector2(x >> TILE_BITS, y >> TILE_BITS));
+            return tile ? tile->elements[getIndex(x, y)] : defaultValue_;
+        }
+
+        void setElement(int x, int y, Element const &value)
+        {
+            if (value != defaultValue_) {
+                addElement(x, y, value);
+            } else {
+                removeElement(x, y);
+            }
+        }
+
+        void clear()
+        {
+            tiles_.clear();
+            counter_.clear();
+            cacheValid_ = false;
+        }
+
+        void swap(ChunkedGrid &other)
+        {
+            std::swap(defaultValue_, other.defaultValue_);
+            tiles_.swap(other.tiles_);
+            counter_.swap(other.counter_);
+            cacheValid_ = false;
+            other.cacheValid_ = false;
+        }
+
+    private:
+        class Tile {
+        public:
+            int count;
+            Element elements[TILE_SIZE * TILE_SIZE];
+
+            explicit Tile(Element const &defaultValue) :
+                count(0)
+            {
+                std::fill(elements, elements + TILE_SIZE * TILE_SIZE,
+                          defaultValue);
+            }
+        };
+
+        class TileHash {
+        public:
+            std::size_t operator()(IntVector2 const &coords) const
+            {
+                return hashValue(hashValue(std::size_t(coords.x)) ^
+                                 std::size_t(coords.y));
+            }
+        };
+
+        typedef boost::ptr_unordered_map<IntVector2, Tile, TileHash> TileMap;
+
+        Element defaultValue_;
+        TileMap tiles_;
+        OccupancyCounter counter_;
+
+        // Most lookups hit the same tile as the previous one.
+        mutable IntVector2 cachedTileCoords_;
+        mutable Tile *cachedTile_;
+        mutable bool cacheValid_;
+
+        // Noncopyable.
+        ChunkedGrid(ChunkedGrid const &other);
+        ChunkedGrid &operator=(ChunkedGrid const &other);
+
+        Tile *findTile(IntVector2 const &tileCoords) const
+        {
+            if (!cacheValid_ || cachedTileCoords_ != tileCoords) {
+                typename TileMap::const_iterator i = tiles_.find(tileCoords);
+                cachedTileCoords_ = tileCoords;
+                cachedTile_ = (i == tiles_.end()) ? 0 : const_cast<Tile *>(i->second);
+                cacheValid_ = true;
+            }
+            return cachedTile_;
+        }
+
+        void addElement(int x, int y, Element const &value)
+        {
+            IntVector2 tileCoords(x >> TILE_BITS, y >> TILE_BITS);
+            Tile *tile = findTile(tileCoords);
+            if (tile == 0) {
+                tile = new Tile(defaultValue_);
+                IntVector2 key(tileCoords);
+                tiles_.insert(key, tile);
+                cachedTile_ = tile;
+            }
+            Element &element = tile->elements[getIndex(x, y)];
+            if (element == defaultValue_) {
+                ++tile->count;
+                counter_.addCell(x, y);
+            }
+            element = value;
+        }
+
+        void removeElement(int x, int y)
+        {
+            IntVector2 tileCoords(x >> TILE_BITS, y >> TILE_BITS);
+            Tile *tile = findTile(tileCoords);
+            if (tile) {
+                Element &element = tile->elements[getIndex(x, y)];
+                if (element != defaultValue_) {
+                    element = defaultValue_;
+                    counter_.removeCell(x, y);
+                    if (--tile->count == 0) {
+                        tiles_.erase(tileCoords);
+                        cachedTile_ = 0;
+                    }
+                }
+            }
+        }
+
+        // Relies on arithmetic shifts and two's complement, so that
+        // negative coordinates map to the right tiles.
+        static int getIndex(int x, int y)
+        {
+            return (y & TILE_MASK) * TILE_SIZE + (x & TILE_MASK);
+        }
+    };
+}
+
+#endif
@@ -4,12 +4,52 @@
 namespace crust {
     class Component {
     public:
+        // Type tags for the concrete components, so that type checks are an
+        // integer comparison instead of a dynamic cast.
+        enum Type {
+            BLOCK_PHYSICS_TYPE,
+            BLOCK_GRAPHICS_TYPE,
+            MONSTER_PHYSICS_TYPE,
+            MONSTER_CONTROL_TYPE,
+            MONSTER_GRAPHICS_TYPE,
+
+            TYPE_COUNT
+        };
+
+        explicit Component(Type type) :
+            type_(type)
+        { }
+
         virtual ~Component()
         { }
 
+        Type getType() const
+        {
+            return type_;
+        }
+
         virtual void create() = 0;
         virtual void destroy() = 0;
+
+    private:
+        Type type_;
     };
+
+    // Returns the component as a T if it has the type tag of T, or null
+    // otherwise.
+    template <typename T>
+    T *componentCast(Component *component)
+    {
+        return ((component && component->getType() == T::componentType) ?
+                static_cast<T *>(component) : 0);
+    }
+
+    template <typename T>
+    T const *componentCast(Component const *component)
+    {
+        return ((component && component->getType() == T::componentType) ?
+                static_cast<T const *>(component) : 0);
+    }
 }
 
 #endif
@@ -12,6 +12,17 @@ namespace crust {
         minCameraScale(0.02f),
         maxCameraScale(1.0f),
         drawFps(true),
-        fps(60)
+        drawSpriteCount(true),
+        drawProfile(false),
+        fps(60),
+        maxStepCount(5),
+        headless(false),
+        headlessStepCount(0),
+        chunkLoadRadius(1),
+        chunkThreadCount(2),
+        chunkCommitCount(64),
+        seed(0),
+        trace(false),
+        tracePath("trace.json")
     { }
 }
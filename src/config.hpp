@@ -1,6 +1,8 @@
 #ifndef CRUST_CONFIG_HPP
 #define CRUST_CONFIG_HPP
 
+#include <string>
+
 namespace crust {
     class Config {
     public:
@@ -14,7 +16,20 @@ namespace crust {
         float minCameraScale;
         float maxCameraScale;
         bool drawFps;
+        bool drawSpriteCount;
+        bool drawProfile;
         int fps;
+        int maxStepCount;
+        bool headless;
+        int headlessStepCount;
+        int chunkLoadRadius;
+        int chunkThreadCount;
+        int chunkCommitCount;
+        int seed;
+        bool trace;
+        std::string tracePath;
+        std::string recordPath;
+        std::string replayPath;
 
         Config();
     };
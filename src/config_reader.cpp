@@ -51,9 +51,48 @@ namespace crust {
         if (key_ == "draw_fps") {
             target_->drawFps = parseBool(value_.c_str());
         }
+        if (key_ == "draw_sprite_count") {
+            target_->drawSpriteCount = parseBool(value_.c_str());
+        }
+        if (key_ == "draw_profile") {
+            target_->drawProfile = parseBool(value_.c_str());
+        }
+        if (key_ == "trace") {
+            target_->trace = parseBool(value_.c_str());
+        }
+        if (key_ == "trace_path") {
+            target_->tracePath = value_;
+        }
+        if (key_ == "record_path") {
+            target_->recordPath = value_;
+        }
+        if (key_ == "replay_path") {
+            target_->replayPath = value_;
+        }
         if (key_ == "fps") {
             target_->fps = parseInt(value_.c_str());
         }
+        if (key_ == "max_step_count") {
+            target_->maxStepCount = parseInt(value_.c_str());
+        }
+        if (key_ == "headless") {
+            target_->headless = parseBool(value_.c_str());
+        }
+        if (key_ == "headless_step_count") {
+            target_->headlessStepCount = parseInt(value_.c_str());
+        }
+        if (key_ == "chunk_load_radius") {
+            target_->chunkLoadRadius = parseInt(value_.c_str());
+        }
+        if (key_ == "chunk_thread_count") {
+            target_->chunkThreadCount = parseInt(value_.c_str());
+        }
+        if (key_ == "chunk_commit_count") {
+            target_->chunkCommitCount = parseInt(value_.c_str());
+        }
+        if (key_ == "seed") {
+            target_->seed = parseInt(value_.c_str());
+        }
     }
 
     bool ConfigReader::parseBool(char const *arg)
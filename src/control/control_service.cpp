@@ -1,5 +1,6 @@
 #include "control_service.hpp"
 
+#include "game.hpp"
 #include "task.hpp"
 
 #include <algorithm>
@@ -22,6 +23,7 @@ namespace crust {
     
     void ControlService::step(float dt)
     {
+        ProfileZone zone(game_->getProfiler(), "CONTROL");
         for (TaskVector::iterator i = tasks_.begin(); i != tasks_.end(); ++i) {
             (*i)->step(dt);
         }
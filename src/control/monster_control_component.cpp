@@ -11,6 +11,7 @@
 
 namespace crust {
     MonsterControlComponent::MonsterControlComponent(Actor *actor) :
+        Component(componentType),
         actor_(actor),
         physicsComponent_(convert(actor->getPhysicsComponent())),
         controlService_(actor->getGame()->getControlService()),
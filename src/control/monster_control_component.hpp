@@ -13,6 +13,8 @@ namespace crust {
     
     class MonsterControlComponent : public Component, public Task {
     public:
+        static Type const componentType = MONSTER_CONTROL_TYPE;
+
         enum ActionMode {
             MINE_MODE,
             DRAG_MODE,
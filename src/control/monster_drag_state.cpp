@@ -9,13 +9,6 @@
 #include "physics_manager.hpp"
 
 namespace crust {
-    namespace {
-        bool isBlock(Actor const *actor)
-        {
-            return dynamic_cast<BlockPhysicsComponent const *>(actor->getPhysicsComponent());
-        }
-    }
-
     MonsterDragState::MonsterDragState(Actor *actor) :
         actor_(actor),
         controlComponent_(convert(actor->getControlComponent())),
@@ -74,13 +67,12 @@ namespace crust {
 
         Vector2 targetPosition = controlComponent_->getTargetPosition();
 
-        for (int i = 0; i < game_->getActorCount(); ++i) {
-            Actor *actor = game_->getActor(i);
-            if (isBlock(actor)) {
-                BlockPhysicsComponent *physicsComponent = convert(actor->getPhysicsComponent());
-                if (physicsComponent->containsPoint(targetPosition)) {
-                    targetActor_ = actor;
-                }
+        PhysicsManager::BlockComponentVector candidates;
+        physicsManager_->findBlockComponents(targetPosition, &candidates);
+        for (std::size_t i = 0; i < candidates.size(); ++i) {
+            BlockPhysicsComponent *physicsComponent = candidates[i];
+            if (physicsComponent->containsPoint(targetPosition)) {
+                targetActor_ = physicsComponent->getActor();
             }
         }
         
@@ -92,7 +84,7 @@ namespace crust {
                 body->SetAngularVelocity(0.0f);
                 body->SetFixedRotation(true);
             }
-            body->SetType(b2_dynamicBody);
+            physicsComponent->makeDynamic();
             body->SetSleepingAllowed(false);
             
             b2MouseJointDef jointDef;
@@ -125,7 +117,7 @@ namespace crust {
             }
         }
         if (makeStatic) {
-            body->SetType(b2_staticBody);
+            physicsComponent->makeStatic();
         }
         body->SetFixedRotation(false);
         body->SetSleepingAllowed(true);
@@ -6,15 +6,9 @@
 #include "monster_control_component.hpp"
 #include "monster_idle_state.hpp"
 #include "convert.hpp"
+#include "physics_manager.hpp"
 
 namespace crust {
-    namespace {
-        bool isBlock(Actor const *actor)
-        {
-            return dynamic_cast<BlockPhysicsComponent const *>(actor->getPhysicsComponent()) != 0;
-        }
-    }
-
     MonsterDropState::MonsterDropState(Actor *actor) :
         actor_(actor),
         controlComponent_(convert(actor->getControlComponent())),
@@ -32,16 +26,17 @@ namespace crust {
     void MonsterDropState::step(float dt)
     {
         Vector2 targetPosition = controlComponent_->getTargetPosition();
-        for (int i = 0; i < actor_->getGame()->getActorCount(); ++i) {
-            Actor *tempActor = actor_->getGame()->getActor(i);
-            if (isBlock(tempActor)) {
-                BlockPhysicsComponent *tempPhysicsComponent = convert(tempActor->getPhysicsComponent());
-                b2Body *tempBody = tempPhysicsComponent->getBody();
-                b2Vec2 tempPositionVec2 = tempBody->GetPosition();
-                Vector2 tempPosition(tempPositionVec2.x, tempPositionVec2.y);
-                if (getSquaredDistance(tempPosition, targetPosition) < square(distance_)) {
-                    tempBody->SetType(b2_dynamicBody);
-                }
+        PhysicsManager *physicsManager = actor_->getGame()->getPhysicsManager();
+        Box2 box(targetPosition - Vector2(distance_),
+                 targetPosition + Vector2(distance_));
+        PhysicsManager::BlockComponentVector candidates;
+        physicsManager->findBlockComponents(box, &candidates);
+        for (std::size_t i = 0; i < candidates.size(); ++i) {
+            BlockPhysicsComponent *tempPhysicsComponent = candidates[i];
+            b2Vec2 tempPositionVec2 = tempPhysicsComponent->getBody()->GetPosition();
+            Vector2 tempPosition(tempPositionVec2.x, tempPositionVec2.y);
+            if (getSquaredDistance(tempPosition, targetPosition) < square(distance_)) {
+                tempPhysicsComponent->makeDynamic();
             }
         }
     }
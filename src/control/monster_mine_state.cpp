@@ -13,11 +13,6 @@
 
 namespace crust {
     namespace {        
-        bool isBlock(Actor const *actor)
-        {
-            return dynamic_cast<BlockPhysicsComponent const *>(actor->getPhysicsComponent());
-        }
-        
         class MineCallback : public b2RayCastCallback {
         public:
             Actor *actor;
@@ -31,7 +26,7 @@ namespace crust {
             {
                 b2Body *body = fixture->GetBody();
                 Actor *tempActor = static_cast<Actor *>(body->GetUserData());
-                if (tempActor && isBlock(tempActor)) {
+                if (tempActor && tempActor->isBlock()) {
                     actor = tempActor;
                     return fraction;
                 } else {
@@ -77,7 +72,7 @@ namespace crust {
         } else {
             targetActor_ = callback.actor;
             if (targetActor_) {
-                targetPhysicsComponent_ = convert(targetActor_->getPhysicsComponent());
+                targetPhysicsComponent_ = componentCast<BlockPhysicsComponent>(targetActor_->getPhysicsComponent());
             } else {
                 targetPhysicsComponent_ = 0;
             }
@@ -2,31 +2,32 @@
 
 #include "actor.hpp"
 #include "actor_factory.hpp"
-#include "block_physics_component.hpp"
+#include "chunk_manager.hpp"
 #include "config.hpp"
 #include "control_service.hpp"
 #include "convert.hpp"
-#include "dungeon_generator.hpp"
 #include "error.hpp"
 #include "geometry.hpp"
 #include "graphics_manager.hpp"
 #include "input_manager.hpp"
+#include "input_recording.hpp"
 #include "monster_control_component.hpp"
 #include "monster_physics_component.hpp"
 #include "physics_manager.hpp"
 
+#include <cmath>
+#include <ctime>
 #include <fstream>
 
 namespace crust {
-    namespace {
-        bool isBlock(Actor const *actor)
-        {
-            return dynamic_cast<BlockPhysicsComponent const *>(actor->getPhysicsComponent());
-        }
-    }
-
-    Game::Game(Config const *config) :
+    Game::Game(Config const *config, AssetPack const *assetPack) :
         config_(config),
+        assetPack_(assetPack),
+        inputPlayer_(config->replayPath.empty() ? 0 : new InputPlayer(config->replayPath.c_str())),
+        seed_(inputPlayer_.get() ? inputPlayer_->getSeed() :
+              config->seed ? Random::Seed(config->seed) : Random::Seed(std::time(0))),
+        random_(Random(seed_).getStream(GAME_STREAM)),
+        graphicsRandom_(Random(seed_).getStream(GRAPHICS_STREAM)),
         quitting_(false),
         windowWidth_(config->windowWidth),
         windowHeight_(config->windowHeight),
@@ -36,34 +37,47 @@ namespace crust {
         appTime_(0.0),
         time_(0.0),
 
-        bounds_(Vector2(-15.0f, -15.0f), Vector2(15.0f, 15.0f)),
-
         fpsTime_(0.0),
         fpsCount_(0),
-    
-        delauneyTriangulation_(bounds_),
-        dungeonGenerator_(&random_, bounds_),
 
-        playerActor_(0)
+        playerActor_(0),
+        cameraActor_(0)
     {
+        std::cout << "Seed " << seed_ << std::endl;
+        if (!config_->recordPath.empty()) {
+            if (config_->fps <= 0) {
+                throw Error("Recording input needs a fixed time step");
+            }
+            inputRecorder_.reset(new InputRecorder(config_->recordPath.c_str(),
+                                                   seed_, config_->fps));
+        }
+        if (config_->trace) {
+            tracer_.reset(new Tracer);
+            profiler_.setTracer(tracer_.get());
+        }
         actorFactory_.reset(new ActorFactory(this));
-        initWindow();
-        initContext();
-        initVoronoiDiagram();
+        if (!config_->headless) {
+            initWindow();
+            initContext();
+        }
         inputManager_.reset(new InputManager(this));
         physicsManager_.reset(new PhysicsManager(this));
         controlService_.reset(new ControlService(this));
-        graphicsManager_.reset(new GraphicsManager(this));
-        initBlocks();
-        initDungeon();
-        initMonsters();
+        if (!config_->headless) {
+            graphicsManager_.reset(new GraphicsManager(this));
+        }
+        initChunks();
+        if (graphicsManager_.get()) {
+            updateCamera();
+        }
     }
     
     Game::~Game()
     {
-        while (!actors_.empty()) {
-            actors_.back().destroy();
-            actors_.pop_back();
+        while (!actors_.isEmpty()) {
+            Actor *actor = actors_.getActor(actors_.getSize() - 1);
+            actor->destroy();
+            actors_.remove(actor->getHandle());
         }
         if (context_) {
             SDL_GL_DeleteContext(context_);
@@ -75,22 +89,53 @@ namespace crust {
 
     void Game::run()
     {
+        if (config_->headless) {
+            runHeadless();
+            writeTrace();
+            return;
+        }
+
         glClearColor(0.0, 0.0, 0.0, 0.0);
         glClear(GL_COLOR_BUFFER_BIT);
+        appTime_ = 0.001 * double(SDL_GetTicks());
+        double accumulator = 0.0;
         while (!quitting_) {
+            profiler_.beginFrame();
             double newAppTime = 0.001 * double(SDL_GetTicks());
-            if (0.1 < newAppTime - appTime_) {
-                appTime_ = newAppTime;
-            }
-            
+            double frameTime = std::min(newAppTime - appTime_, 0.1);
+            appTime_ = newAppTime;
+
+            float alpha = 1.0f;
             if (config_->fps) {
                 double dt = 1.0 / double(config_->fps);
-                while (dt < float(newAppTime - appTime_)) {
+                accumulator += frameTime;
+                int stepCount = 0;
+                while (dt <= accumulator && stepCount < config_->maxStepCount) {
                     runStep(float(dt));
+                    accumulator -= dt;
+                    ++stepCount;
                 }
+
+                // Drop the time that we failed to catch up with, rather than
+                // falling further and further behind.
+                if (dt <= accumulator) {
+                    accumulator = std::fmod(accumulator, dt);
+                }
+                alpha = float(accumulator / dt);
             } else {
-                runStep(float(newAppTime - appTime_));
+                runStep(float(frameTime));
             }
+            drawFrame(alpha);
+            profiler_.endFrame();
+        }
+        writeTrace();
+    }
+
+    void Game::writeTrace()
+    {
+        if (tracer_.get()) {
+            tracer_->write(config_->tracePath.c_str());
+            std::cout << "Wrote trace to " << config_->tracePath << std::endl;
         }
     }
     
@@ -106,21 +151,14 @@ namespace crust {
 
     Actor *Game::addActor(std::auto_ptr<Actor> actor)
     {
-        actors_.push_back(actor);
-        actors_.back().create();
-        return &actors_.back();
+        Actor *result = actors_.get(actors_.add(actor));
+        result->create();
+        return result;
     }
 
     void Game::removeActor(Actor *actor)
     {
-        ActorVector::auto_type removedActor;
-        for (ActorIterator i = actors_.begin(); i != actors_.end(); ++i) {
-            if (&*i == actor) {
-                i->destroy();
-                actors_.erase(i);
-                break;
-            }
-        }
+        removedActors_.push_back(actor->getHandle());
     }
     
     void Game::initWindow()
@@ -159,126 +197,175 @@ namespace crust {
         SDL_GL_SetSwapInterval(config_->vsync ? 1 : 0);
     }
     
-    void Game::initVoronoiDiagram()
+    void Game::initChunks()
     {
-        Box2 vertexBounds = bounds_;
-        vertexBounds.pad(5.0f);
-        Box2 triangulationBounds = vertexBounds;
-        triangulationBounds.pad(5.0f);
-        delauneyTriangulation_ = DelauneyTriangulation(triangulationBounds);
-        int subdivCount = 30;
-        float subdivWidth = float(vertexBounds.getWidth()) / float(subdivCount);
-        float subdivHeight = float(vertexBounds.getHeight()) / float(subdivCount);
-        for (int i = 0; i < subdivCount; ++i) {
-            for (int j = 0; j < subdivCount; ++j) {
-                float x = vertexBounds.p1.x + (float(i) + getRandomFloat()) * subdivWidth;
-                float y = vertexBounds.p1.y + (float(j) + getRandomFloat()) * subdivHeight;
-                delauneyTriangulation_.addVertex(Vector2(x, y));
-            }
-        }
-        voronoiDiagram_.generate(delauneyTriangulation_);
-    }
+        TraceZone zone(tracer_.get(), "CHUNKS");
 
-    void Game::initBlocks()
-    {
-        Box2 paddedBounds = bounds_;
-        paddedBounds.pad(2.0f);
-        for (int i = 0; i < voronoiDiagram_.getPolygonCount(); ++i) {
-            Polygon2 polygon = voronoiDiagram_.getPolygon(i);
-            if (contains(paddedBounds, polygon)) {
-                addActor(actorFactory_->createBlock(polygon));
-            }
-        }
+        // Worker threads commit chunks at whatever step they finish on, so
+        // recordings and replays generate them on the main thread.
+        bool deterministic = inputRecorder_.get() || inputPlayer_.get();
+        int threadCount = deterministic ? 0 : config_->chunkThreadCount;
+        chunkManager_.reset(new ChunkManager(this, seed_, config_->chunkLoadRadius,
+                                             threadCount,
+                                             config_->chunkCommitCount));
+        chunkManager_->update(Vector2(0.0f));
     }
 
-    void Game::initDungeon()
+    // Waits for the chunks around the spawn point, so that the player does
+    // not fall through blocks that have not been committed yet.
+    void Game::initMonsters()
     {
-        dungeonGenerator_.generate();
-        for (int i = 0; i < dungeonGenerator_.getRoomBoxCount(); ++i) {
-            removeBlocks(dungeonGenerator_.getRoomBox(i));
+        if (chunkManager_->getPendingChunkCount()) {
+            return;
         }
-        for (int i = 0; i < dungeonGenerator_.getCorridorBoxCount(); ++i) {
-            removeBlocks(dungeonGenerator_.getCorridorBox(i));
+        TraceZone zone(tracer_.get(), "MONSTERS");
+        Vector2 position;
+        if (chunkManager_->findRoomCenter(Vector2(0.0f), &position)) {
+            playerActor_ = addActor(actorFactory_->createMonster(position));
         }
     }
 
-    void Game::initMonsters()
+    // Steps the world with a fixed time step as fast as possible, without
+    // any window, context or graphics. Useful for soak tests and profiling.
+    // Replays use the step rate of the recording.
+    void Game::runHeadless()
     {
-        if (dungeonGenerator_.getRoomBoxCount()) {
-            Vector2 position = dungeonGenerator_.getRoomBox(0).getCenter();
-            playerActor_ = addActor(actorFactory_->createMonster(position));
+        int fps = inputPlayer_.get() ? inputPlayer_->getFps() : config_->fps;
+        float dt = 1.0f / float(fps ? fps : 60);
+        Uint32 startTicks = SDL_GetTicks();
+        int stepCount = 0;
+        while (!quitting_) {
+            // Stop before stepping, so that a replay runs exactly the
+            // recorded steps.
+            if (inputPlayer_.get() && inputPlayer_->isFinished()) {
+                break;
+            }
+
+            profiler_.beginFrame();
+            appTime_ = 0.001 * double(SDL_GetTicks());
+            time_ += dt;
+            if (updateFps()) {
+                std::cout << fpsText_ << std::endl;
+            }
+            step(dt);
+            profiler_.endFrame();
+
+            ++stepCount;
+            if (config_->headlessStepCount &&
+                config_->headlessStepCount <= stepCount)
+            {
+                quitting_ = true;
+            }
+        }
+
+        if (inputPlayer_.get()) {
+            std::cout << "Replayed " << inputPlayer_->getFrameIndex() << " of "
+                      << inputPlayer_->getFrameCount() << " steps in "
+                      << 0.001 * double(SDL_GetTicks() - startTicks)
+                      << " seconds" << std::endl;
         }
     }
 
     void Game::runStep(float dt)
     {
-        appTime_ += dt;
         time_ += dt;
-        
-        updateFps();
-        step(float(dt));
+        step(dt);
         updateCamera();
+    }
 
-        SDL_GL_SwapWindow(window_);
+    void Game::drawFrame(float alpha)
+    {
+        updateFps();
+
+        {
+            ProfileZone zone(&profiler_, "SWAP");
+            SDL_GL_SwapWindow(window_);
+        }
         glClearColor(double(0x66) / 255.0, double(0x55) / 255.0, double(0x44) / 255.0, 0.0);
         glClear(GL_COLOR_BUFFER_BIT);
-        graphicsManager_->draw();
+        graphicsManager_->draw(alpha);
     }
 
-    void Game::updateFps()
+    bool Game::updateFps()
     {
+        bool updated = false;
         if (fpsTime_ < appTime_) {
             char buffer[64];
             sprintf(buffer, "%g FPS", float(fpsCount_));
             fpsText_ = buffer;
             fpsTime_ = appTime_ + 1.0f;
             fpsCount_ = 0;
+            updated = true;
         }
 
         ++fpsCount_;
+        return updated;
     }
     
     void Game::updateCamera()
     {
+        if (!playerActor_) {
+            return;
+        }
         MonsterPhysicsComponent *physicsComponent = convert(playerActor_->getPhysicsComponent());
         b2Vec2 position = physicsComponent->getMainBody()->GetPosition();
-        graphicsManager_->setCameraPosition(Vector2(position.x, position.y));
+        if (cameraActor_ == playerActor_) {
+            graphicsManager_->setCameraPosition(Vector2(position.x, position.y));
+        } else {
+            // Snap to a new player, rather than sweeping in from the old
+            // camera position.
+            graphicsManager_->resetCameraPosition(Vector2(position.x, position.y));
+            cameraActor_ = playerActor_;
+        }
+    }
+
+    // Streams the chunks around the player, or around the camera when
+    // there is no player. The camera lags the player by a step, so going by
+    // the player loads the same chunks with and without graphics.
+    void Game::updateChunks()
+    {
+        ProfileZone zone(&profiler_, "CHUNKS");
+        Vector2 position;
+        if (playerActor_) {
+            MonsterPhysicsComponent *physicsComponent = convert(playerActor_->getPhysicsComponent());
+            b2Vec2 playerPosition = physicsComponent->getMainBody()->GetPosition();
+            position = Vector2(playerPosition.x, playerPosition.y);
+        } else if (graphicsManager_.get()) {
+            position = graphicsManager_->getCameraPosition();
+        }
+        chunkManager_->update(position);
     }
     
     void Game::step(float dt)
     {
+        ProfileZone zone(&profiler_, "STEP");
         inputManager_->step(dt);
         controlService_->step(dt);
         physicsManager_->step(dt);
         handleCollisions();
-        for (ActorIterator i = actors_.begin(); i != actors_.end(); ++i) {
-            Actor *actor = &*i;
-            if (isBlock(actor)) {
-                b2Body *body = static_cast<BlockPhysicsComponent *>(actor->getPhysicsComponent())->getBody();
-                if (body->GetType() != b2_staticBody && !body->IsAwake()) {
-                    body->SetType(b2_staticBody);
-                }
-            }
+        if (graphicsManager_.get()) {
+            graphicsManager_->step(dt);
+        }
+        updateChunks();
+        destroyRemovedActors();
+        if (!playerActor_) {
+            initMonsters();
         }
-        graphicsManager_->step(dt);
     }
 
     void Game::handleCollisions()
     { }
 
-    void Game::removeBlocks(Box2 const &box)
+    void Game::destroyRemovedActors()
     {
-        for (ActorIterator i = actors_.begin(); i != actors_.end(); ++i) {
-            Actor *actor = &*i;
-            if (isBlock(actor)) {
-                BlockPhysicsComponent *physicsComponent = convert(actor->getPhysicsComponent());
-                b2Vec2 position = physicsComponent->getBody()->GetPosition();
-                if (box.containsPoint(Vector2(position.x, position.y))) {
-                    int j = i - actors_.begin();
-                    removeActor(actor);
-                    i = actors_.begin() + j - 1;
-                }
+        for (std::size_t i = 0; i < removedActors_.size(); ++i) {
+            // The same actor may have been removed more than once.
+            Actor *actor = actors_.get(removedActors_[i]);
+            if (actor) {
+                actor->destroy();
+                actors_.remove(removedActors_[i]);
             }
         }
+        removedActors_.clear();
     }
 }
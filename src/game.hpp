@@ -1,37 +1,47 @@
 #ifndef CRUST_GAME_HPP
 #define CRUST_GAME_HPP
 
-#include "delauney_triangulation.hpp"
-#include "dungeon_generator.hpp"
+#include "actor_store.hpp"
 #include "geometry.hpp"
+#include "profiler.hpp"
 #include "random.hpp"
-#include "voronoi_diagram.hpp"
+#include "tracer.hpp"
 
 #include <iostream>
 #include <map>
 #include <memory>
 #include <sstream>
-#include <boost/ptr_container/ptr_vector.hpp>
+#include <vector>
 #include <SDL/SDL.h>
 #include <SDL/SDL_opengl.h>
 
 namespace crust {
     class Actor;
     class ActorFactory;
+    class AssetPack;
+    class ChunkManager;
     class Config;
     class ControlService;
     class Font;
     class GraphicsManager;
     class InputManager;
+    class InputPlayer;
+    class InputRecorder;
     class PhysicsManager;
 
+    // Independent random streams for the subsystems, so that a change in
+    // how many numbers one of them draws does not shift the others.
+    enum RandomStream {
+        GAME_STREAM,
+        DUNGEON_STREAM,
+        ROTATION_STREAM,
+        COLOR_STREAM,
+        GRAPHICS_STREAM
+    };
+
     class Game {
     public:
-        typedef boost::ptr_vector<Actor> ActorVector;
-        typedef ActorVector::iterator ActorIterator;
-        typedef ActorVector::const_iterator ConstActorIterator;
-
-        explicit Game(Config const *config);
+        Game(Config const *config, AssetPack const *assetPack);
         ~Game();
         
         void run();
@@ -46,6 +56,11 @@ namespace crust {
             return config_;
         }
 
+        AssetPack const *getAssetPack() const
+        {
+            return assetPack_;
+        }
+
         SDL_Window *getWindow()
         {
             return window_;
@@ -56,18 +71,27 @@ namespace crust {
             return time_;
         }
 
+        // The world seed. Taken from the replayed recording, the config, or
+        // the current time, in that order.
+        Random::Seed getSeed() const
+        {
+            return seed_;
+        }
+
         Random *getRandom()
         {
             return &random_;
         }
-        
-        float getRandomFloat();
-        int getRandomInt(int size);
 
-        ActorVector const &getActors() const
+        // For effects that only show up in the graphics, so that replays
+        // without graphics draw the same simulation numbers.
+        Random *getGraphicsRandom()
         {
-            return actors_;
+            return &graphicsRandom_;
         }
+        
+        float getRandomFloat();
+        int getRandomInt(int size);
 
         Actor *getPlayerActor()
         {
@@ -84,22 +108,58 @@ namespace crust {
             return fpsText_.c_str();
         }
 
+        Profiler *getProfiler()
+        {
+            return &profiler_;
+        }
+
+        // Null unless tracing is enabled in the config.
+        Tracer *getTracer()
+        {
+            return tracer_.get();
+        }
+
+        void writeTrace();
+
         Actor *addActor(std::auto_ptr<Actor> actor);
+
+        // Removal is deferred until the end of the current step, so that
+        // actors can safely be removed while stepping.
         void removeActor(Actor *actor);
 
         int getActorCount() const
         {
-            return int(actors_.size());
+            return actors_.getSize();
         }
 
         Actor *getActor(int i)
         {
-            return &actors_[i];
+            return actors_.getActor(i);
         }
 
         Actor const *getActor(int i) const
         {
-            return &actors_[i];
+            return actors_.getActor(i);
+        }
+
+        Actor *getActor(ActorHandle const &handle)
+        {
+            return actors_.get(handle);
+        }
+
+        Actor const *getActor(ActorHandle const &handle) const
+        {
+            return actors_.get(handle);
+        }
+
+        ActorFactory *getActorFactory()
+        {
+            return actorFactory_.get();
+        }
+
+        ChunkManager *getChunkManager()
+        {
+            return chunkManager_.get();
         }
 
         InputManager *getInputManager()
@@ -112,6 +172,18 @@ namespace crust {
             return inputManager_.get();
         }
 
+        // Null unless a record path is set in the config.
+        InputRecorder *getInputRecorder()
+        {
+            return inputRecorder_.get();
+        }
+
+        // Null unless a replay path is set in the config.
+        InputPlayer *getInputPlayer()
+        {
+            return inputPlayer_.get();
+        }
+
         PhysicsManager *getPhysicsManager()
         {
             return physicsManager_.get();
@@ -139,7 +211,12 @@ namespace crust {
 
     private:
         Config const *config_;
+        AssetPack const *assetPack_;
+        std::auto_ptr<InputPlayer> inputPlayer_;
+        std::auto_ptr<InputRecorder> inputRecorder_;
+        Random::Seed seed_;
         Random random_;
+        Random graphicsRandom_;
         bool quitting_;
         int windowWidth_;
         int windowHeight_;
@@ -151,41 +228,42 @@ namespace crust {
 
         bool blockGrowthDone_;
         bool dungeonGenerationDone_;
-        
-        Box2 bounds_;
 
         double fpsTime_;
         int fpsCount_;
         std::string fpsText_;
-        
-        DelauneyTriangulation delauneyTriangulation_;
-        VoronoiDiagram voronoiDiagram_;
-        DungeonGenerator dungeonGenerator_;
+        Profiler profiler_;
+        std::auto_ptr<Tracer> tracer_;
 
         std::auto_ptr<InputManager> inputManager_;
         std::auto_ptr<PhysicsManager> physicsManager_;
         std::auto_ptr<ControlService> controlService_;
         std::auto_ptr<GraphicsManager> graphicsManager_;
         std::auto_ptr<ActorFactory> actorFactory_;
+        std::auto_ptr<ChunkManager> chunkManager_;
 
-        ActorVector actors_;
+        ActorStore actors_;
+        std::vector<ActorHandle> removedActors_;
         Actor *playerActor_;
 
+        // The actor that the camera followed in the last update.
+        Actor *cameraActor_;
+
         void initWindow();
         void initContext();
-        void initVoronoiDiagram();
-        void initBlocks();
-        void initDungeon();
+        void initChunks();
         void initMonsters();
 
+        void runHeadless();
         void runStep(float dt);
-        void updateFps();
+        void drawFrame(float alpha);
+        bool updateFps();
         void updateCamera();
+        void updateChunks();
 
         void step(float dt);
         void handleCollisions();
-        
-        void removeBlocks(Box2 const &box);
+        void destroyRemovedActors();
     };
 }
 
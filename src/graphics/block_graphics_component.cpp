@@ -2,21 +2,28 @@
 
 #include "actor.hpp"
 #include "block_physics_component.hpp"
+#include "block_state.hpp"
 #include "color_generator.hpp"
 #include "convert.hpp"
 #include "game.hpp"
 #include "graphics_manager.hpp"
-#include "grid.hpp"
 #include "hash.hpp"
 #include "random.hpp"
 #include "sprite.hpp"
 
 namespace crust {
-    BlockGraphicsComponent::BlockGraphicsComponent(Actor *actor) :
+    BlockGraphicsComponent::BlockGraphicsComponent(Actor *actor,
+                                                   BlockState const *state) :
+        Component(componentType),
         actor_(actor),
         physicsComponent_(convert(actor->getPhysicsComponent())),
         graphicsManager_(actor->getGame()->getGraphicsManager())
-    { }
+    {
+        if (state && !state->gridColors.empty()) {
+            colorBox_ = state->gridBox;
+            colors_ = state->gridColors;
+        }
+    }
 
     BlockGraphicsComponent::~BlockGraphicsComponent()
     { }
@@ -47,28 +54,49 @@ namespace crust {
         sprite_->setAngle(angle);
     }
     
+    void BlockGraphicsComponent::getColors(BlockState *state) const
+    {
+        IntBox2 const &box = state->gridBox;
+        state->gridColors.clear();
+        state->gridColors.reserve(box.getArea());
+        for (int y = box.p1.y; y < box.p2.y; ++y) {
+            for (int x = box.p1.x; x < box.p2.x; ++x) {
+                Color4 const &pixel = sprite_->getPixel(x, y);
+                state->gridColors.push_back(Color3(pixel.red, pixel.green, pixel.blue));
+            }
+        }
+    }
+
     void BlockGraphicsComponent::initSprite()
     {
-        Grid<unsigned char> const &grid = physicsComponent_->getGrid();
+        BitGrid const &grid = physicsComponent_->getGrid();
 
         sprite_.reset(new Sprite);
         sprite_->setScale(Vector2(0.1f));
 
         int x = grid.getX();
         int y = grid.getY();
-        int width = grid.getWidth();
         int height = grid.getHeight();
 
-        ColorGenerator colorGenerator(actor_->getGame()->getRandom());
+        ColorGenerator colorGenerator(actor_->getGame()->getGraphicsRandom());
 
-        for (int dy = 0; dy < height; ++dy) {
-            for (int dx = 0; dx < width; ++dx) {
-                int type = grid.getElement(x + dx, y + dy);
-                if (type) {
-                    Color3 color = colorGenerator.generateColor();
-                    sprite_->setPixel(x + dx, y + dy, Color4(color.red, color.green, color.blue));
+        for (int cellY = y; cellY < y + height; ++cellY) {
+            // Skip over empty cells a word at a time.
+            int cellX = x;
+            while (grid.findFirstInRow(cellY, cellX, &cellX)) {
+                Color3 color;
+                if (colors_.empty()) {
+                    color = colorGenerator.generateColor();
+                } else {
+                    color = colors_[(cellY - colorBox_.p1.y) * colorBox_.getWidth() +
+                                    (cellX - colorBox_.p1.x)];
                 }
+                sprite_->setPixel(cellX, cellY, Color4(color.red, color.green, color.blue));
+                ++cellX;
             }
         }
+
+        // Only needed until the sprite has been created.
+        std::vector<Color3>().swap(colors_);
     }
 }
@@ -1,26 +1,38 @@
 #ifndef CRUST_BLOCK_GRAPHICS_COMPONENT_HPP
 #define CRUST_BLOCK_GRAPHICS_COMPONENT_HPP
 
+#include "color.hpp"
 #include "component.hpp"
+#include "int_geometry.hpp"
 #include "task.hpp"
 
 #include <memory>
+#include <vector>
 
 namespace crust {
     class Actor;
     class BlockPhysicsComponent;
+    class BlockState;
     class GraphicsManager;
     class Sprite;
     
     class BlockGraphicsComponent : public Component, public Task {
     public:
-        explicit BlockGraphicsComponent(Actor *actor);
+        static Type const componentType = BLOCK_GRAPHICS_TYPE;
+
+        // Uses the grid colors of the state if there are any, and
+        // generates new colors otherwise.
+        explicit BlockGraphicsComponent(Actor *actor,
+                                        BlockState const *state = 0);
         ~BlockGraphicsComponent();
 
         void create();
         void destroy();
 
         void step(float dt);
+
+        // Fills in the grid colors for the grid box of the state.
+        void getColors(BlockState *state) const;
         
     private:
         Actor *actor_;
@@ -28,6 +40,9 @@ namespace crust {
         GraphicsManager *graphicsManager_;
 
         std::auto_ptr<Sprite> sprite_;
+
+        IntBox2 colorBox_;
+        std::vector<Color3> colors_;
         
         void initSprite();
     };
@@ -0,0 +1,62 @@
+#include "font_packer.hpp"
+
+#include "error.hpp"
+#include "font.hpp"
+
+namespace crust {
+    void FontPacker::write(Font *source, std::vector<char> *target)
+    {
+        int height = source->getGlyphHeight(0);
+        target->push_back(char(height));
+        for (int i = 0; i < 256; ++i) {
+            char key = char(i);
+            int width = source->getGlyphWidth(key);
+            if (width == 0) {
+                continue;
+            }
+            target->push_back(key);
+            target->push_back(char(width));
+            std::size_t offset = target->size();
+            target->resize(offset + (width * height + 7) / 8, 0);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    if (source->getGlyphPixel(key, x, y)) {
+                        int index = y * width + x;
+                        (*target)[offset + index / 8] |= char(1 << (index % 8));
+                    }
+                }
+            }
+        }
+    }
+
+    void FontPacker::read(char const *data, std::size_t size, Font *target)
+    {
+        unsigned char const *bytes = reinterpret_cast<unsigned char const *>(data);
+        if (size == 0) {
+            throw Error("Empty font pack");
+        }
+        int height = bytes[0];
+        std::size_t offset = 1;
+        while (offset < size) {
+            if (size - offset < 2) {
+                throw Error("Truncated font pack");
+            }
+            char key = char(bytes[offset]);
+            int width = bytes[offset + 1];
+            offset += 2;
+            std::size_t glyphSize = (width * height + 7) / 8;
+            if (size - offset < glyphSize) {
+                throw Error("Truncated font pack");
+            }
+            target->addGlyph(key, width, height);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    int index = y * width + x;
+                    bool value = (bytes[offset + index / 8] >> (index % 8)) & 1;
+                    target->setGlyphPixel(key, x, y, value);
+                }
+            }
+            offset += glyphSize;
+        }
+    }
+}
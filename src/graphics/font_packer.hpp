@@ -0,0 +1,20 @@
+#ifndef CRUST_FONT_PACKER_HPP
+#define CRUST_FONT_PACKER_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace crust {
+    class Font;
+
+    // Binary form of a font for the asset pack. The glyph height comes
+    // first, followed by a record for each glyph with its key, its width
+    // and its pixels, row by row and packed eight to a byte.
+    class FontPacker {
+    public:
+        void write(Font *source, std::vector<char> *target);
+        void read(char const *data, std::size_t size, Font *target);
+    };
+}
+
+#endif
@@ -1,22 +1,34 @@
 #include "graphics_manager.hpp"
 
 #include "actor.hpp"
+#include "asset_pack.hpp"
 #include "block_physics_component.hpp"
 #include "config.hpp"
 #include "convert.hpp"
 #include "font.hpp"
-#include "font_reader.hpp"
+#include "font_packer.hpp"
 #include "game.hpp"
 #include "monster_control_component.hpp"
 #include "physics_manager.hpp"
+#include "profiler.hpp"
 #include "sprite.hpp"
 #include "task.hpp"
 #include "text_renderer.hpp"
 
 #include <algorithm>
-#include <fstream>
+#include <cstdio>
+#include <iterator>
+#include <sstream>
 
 namespace crust {
+    namespace {
+        bool lessDrawOrder(Sprite const *s1, Sprite const *s2)
+        {
+            return s1->getDrawOrder() < s2->getDrawOrder();
+        }
+    }
+
+
     GraphicsManager::GraphicsManager(Game *game) :
         game_(game),
         window_(game->getWindow()),
@@ -26,12 +38,18 @@ namespace crust {
         cameraScale_(game->getConfig()->cameraScale),
     
         drawEnabled_(true),
-        debugDrawEnabled_(false)
+        debugDrawEnabled_(false),
+        profileDrawEnabled_(game->getConfig()->drawProfile),
+
+        spriteHash_(2.0f),
+        nextSpriteDrawOrder_(0),
+        spriteBatch_(game->getProfiler())
     {
         SDL_GetWindowSize(window_, &windowWidth_, &windowHeight_);
 
         initFont();
         initShaders();
+        initSpriteBatch();
         initFrameBuffer();
     }
 
@@ -40,15 +58,23 @@ namespace crust {
 
     void GraphicsManager::step(float dt)
     {
+        ProfileZone zone(game_->getProfiler(), "GRAPHICS");
+        previousCameraPosition_ = cameraPosition_;
+        for (SpriteVector::iterator i = sprites_.begin(); i != sprites_.end(); ++i) {
+            (*i)->saveState();
+        }
         for (TaskVector::iterator i = tasks_.begin(); i != tasks_.end(); ++i) {
             (*i)->step(dt);
         }
+        updateSpriteHash();
     }
     
-    void GraphicsManager::draw()
+    void GraphicsManager::draw(float alpha)
     {
-        updateFrustum();
-        drawWorld();
+        ProfileZone zone(game_->getProfiler(), "DRAW");
+        updateFrustum(alpha);
+        findVisibleSprites();
+        drawWorld(alpha);
         drawHud();
     }
     
@@ -63,13 +89,19 @@ namespace crust {
 
     void GraphicsManager::addSprite(Sprite *sprite)
     {
+        sprite->setDrawOrder(nextSpriteDrawOrder_++);
         sprites_.push_back(sprite);
+        Circle2 bounds = sprite->getBounds();
+        spriteHash_.insert(sprite, bounds.center, bounds.radius);
+        sprite->setBoundsDirty(false);
     }
 
     void GraphicsManager::removeSprite(Sprite *sprite)
     {
         SpriteVector::iterator i = std::find(sprites_.begin(), sprites_.end(), sprite);
         sprites_.erase(i);
+        spriteHash_.remove(sprite);
+        spriteBatch_.removeSprite(sprite);
     }
 
     void GraphicsManager::addTask(Task *task)
@@ -86,19 +118,27 @@ namespace crust {
     void GraphicsManager::initFont()
     {
         font_.reset(new Font);
-        std::ifstream in("../../../data/font.txt");
-        FontReader reader;
-        reader.read(&in, font_.get());
+        Asset asset = game_->getAssetPack()->getAsset("font");
+        FontPacker packer;
+        packer.read(asset.data, asset.size, font_.get());
         textRenderer_.reset(new TextRenderer(font_.get()));
     }
 
     void GraphicsManager::initShaders()
     {
-        shaderProgram_.setVertexShaderPath("../../../data/vertex.glsl");
-        shaderProgram_.setFragmentShaderPath("../../../data/fragment.glsl");
+        AssetPack const *assetPack = game_->getAssetPack();
+        shaderProgram_.setVertexShader("vertex.glsl",
+                                       assetPack->getAsset("vertex.glsl"));
+        shaderProgram_.setFragmentShader("fragment.glsl",
+                                         assetPack->getAsset("fragment.glsl"));
         shaderProgram_.create();
     }
 
+    void GraphicsManager::initSpriteBatch()
+    {
+        spriteBatch_.create();
+    }
+
     void GraphicsManager::initFrameBuffer()
     {
         colorTexture_.setSize(windowWidth_, windowHeight_);
@@ -107,17 +147,39 @@ namespace crust {
         frameBuffer_.create();
     }
     
-    void GraphicsManager::updateFrustum()
+    void GraphicsManager::updateFrustum(float alpha)
     {
+        Vector2 position = mix(previousCameraPosition_, cameraPosition_, alpha);
         float invScale = 1.0f / cameraScale_;
         float aspectRatio = float(windowWidth_) / float(windowHeight_);
-        frustum_ = Box2(Vector2(cameraPosition_.x - invScale * aspectRatio,
-                                cameraPosition_.y - invScale),
-                        Vector2(cameraPosition_.x + invScale * aspectRatio,
-                                cameraPosition_.y + invScale));
+        frustum_ = Box2(Vector2(position.x - invScale * aspectRatio,
+                                position.y - invScale),
+                        Vector2(position.x + invScale * aspectRatio,
+                                position.y + invScale));
     }
 
-    void GraphicsManager::drawWorld()
+    void GraphicsManager::updateSpriteHash()
+    {
+        for (SpriteVector::iterator i = sprites_.begin(); i != sprites_.end(); ++i) {
+            if ((*i)->isBoundsDirty()) {
+                Circle2 bounds = (*i)->getBounds();
+                spriteHash_.move(*i, bounds.center, bounds.radius);
+                (*i)->setBoundsDirty(false);
+            }
+        }
+    }
+
+    // Sprites with bounds outside the frustum are culled. The rest are
+    // drawn in the order they were added.
+    void GraphicsManager::findVisibleSprites()
+    {
+        visibleSprites_.clear();
+        spriteHash_.findValues(frustum_, std::back_inserter(visibleSprites_));
+        std::sort(visibleSprites_.begin(), visibleSprites_.end(),
+                  &lessDrawOrder);
+    }
+
+    void GraphicsManager::drawWorld(float alpha)
     {
         if (drawEnabled_) {
             setWorldProjection();
@@ -127,7 +189,7 @@ namespace crust {
             glEnable(GL_BLEND);
             glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
             shaderProgram_.bind();
-            drawSprites();
+            drawSprites(alpha);
             shaderProgram_.unbind();
             glDisable(GL_BLEND);
             frameBuffer_.unbind();
@@ -169,6 +231,13 @@ namespace crust {
         if (game_->getConfig()->drawFps) {
             drawFps();
         }
+        if (game_->getConfig()->drawSpriteCount) {
+            drawSpriteCount();
+        }
+        if (profileDrawEnabled_) {
+            drawProfile();
+        }
+        textRenderer_->releaseUnusedBuffers();
     }
     
     void GraphicsManager::drawMode()
@@ -211,6 +280,65 @@ namespace crust {
         glPopMatrix();
     }
     
+    void GraphicsManager::drawSpriteCount()
+    {
+        std::stringstream out;
+        out << "SPRITES " << visibleSprites_.size() << "/" << sprites_.size();
+
+        int scale = 3;
+        glPushMatrix();
+        glTranslatef(2.0f * float(scale), 2.0f * float(scale), 0.0f);
+        if (game_->getConfig()->drawFps) {
+            glTranslatef(0.0f, float(scale) * (textRenderer_->getHeight("X") + 2.0f), 0.0f);
+        }
+        glScalef(float(scale), float(scale), 1.0);
+        textRenderer_->draw(out.str().c_str());
+        glPopMatrix();
+    }
+
+    void GraphicsManager::drawProfile()
+    {
+        char const *headers[] = { "MIN", "AVG", "MAX", "P50", "P95", "P99" };
+        int scale = 2;
+        int lineHeight = textRenderer_->getHeight("X") + 4;
+        int nameWidth = 100;
+        int columnWidth = 40;
+
+        Profiler *profiler = game_->getProfiler();
+        glPushMatrix();
+        glTranslatef(2.0f * float(scale), float(windowHeight_) - float(scale) * float(4 * lineHeight), 0.0f);
+        glScalef(float(scale), float(scale), 1.0);
+        glPushMatrix();
+        textRenderer_->draw("MS");
+        for (int i = 0; i < 6; ++i) {
+            glTranslatef(float(i ? columnWidth : nameWidth), 0.0f, 0.0f);
+            textRenderer_->draw(headers[i]);
+        }
+        glPopMatrix();
+        for (int i = 0; i < profiler->getZoneCount(); ++i) {
+            ProfileStats stats = profiler->getZoneStats(i);
+            float values[] = {
+                stats.min, stats.average, stats.max,
+                stats.median, stats.percentile95, stats.percentile99
+            };
+
+            glTranslatef(0.0f, -float(lineHeight), 0.0f);
+            glPushMatrix();
+            glTranslatef(float(8 * profiler->getZoneDepth(i)), 0.0f, 0.0f);
+            textRenderer_->draw(profiler->getZoneName(i));
+            glPopMatrix();
+            glPushMatrix();
+            for (int j = 0; j < 6; ++j) {
+                char buffer[32];
+                sprintf(buffer, "%.2f", values[j]);
+                glTranslatef(float(j ? columnWidth : nameWidth), 0.0f, 0.0f);
+                textRenderer_->draw(buffer);
+            }
+            glPopMatrix();
+        }
+        glPopMatrix();
+    }
+
     void GraphicsManager::setWorldProjection()
     {
         glMatrixMode(GL_PROJECTION);
@@ -229,17 +357,16 @@ namespace crust {
         glMatrixMode(GL_MODELVIEW);
     }
 
-    void GraphicsManager::drawSprites()
+    void GraphicsManager::drawSprites(float alpha)
     {
+        ProfileZone zone(game_->getProfiler(), "SPRITES");
         shaderProgram_.setUniform("colorTexture", 0);
         shaderProgram_.setUniform("normalAndShadowTexture", 1);
         float smoothDistance = 1.25f / (0.1f * cameraScale_ * float(windowHeight_));
         shaderProgram_.setUniform("smoothDistance", smoothDistance);
-        GLint textureSizeLocation = shaderProgram_.getUniformLocation("textureSize");
-        for (SpriteVector::iterator i = sprites_.begin(); i != sprites_.end(); ++i) {
-            IntVector2 size = (*i)->getSize();
-            glUniform2f(textureSizeLocation, GLfloat(size.x), GLfloat(size.y));
-            (*i)->draw();
+        for (SpriteVector::iterator i = visibleSprites_.begin(); i != visibleSprites_.end(); ++i) {
+            spriteBatch_.addSprite(*i, alpha);
         }
+        spriteBatch_.draw(&shaderProgram_);
     }
 }
@@ -4,6 +4,8 @@
 #include "frame_buffer.hpp"
 #include "geometry.hpp"
 #include "shader_program.hpp"
+#include "spatial_hash.hpp"
+#include "sprite_batch.hpp"
 #include "texture.hpp"
 
 #include <vector>
@@ -26,7 +28,7 @@ namespace crust {
         ~GraphicsManager();
 
         void step(float dt);
-        void draw();
+        void draw(float alpha);
 
         Vector2 const &getCameraPosition() const
         {
@@ -38,6 +40,13 @@ namespace crust {
             cameraPosition_ = position;
         }
 
+        // Moves the camera without interpolating from the old position.
+        void resetCameraPosition(Vector2 const &position)
+        {
+            previousCameraPosition_ = position;
+            cameraPosition_ = position;
+        }
+
         float getCameraScale() const
         {
             return cameraScale_;
@@ -56,6 +65,16 @@ namespace crust {
         void addTask(Task *task);
         void removeTask(Task *task);
 
+        bool isProfileDrawEnabled() const
+        {
+            return profileDrawEnabled_;
+        }
+
+        void setProfileDrawEnabled(bool enabled)
+        {
+            profileDrawEnabled_ = enabled;
+        }
+
     private:
         Game *game_;
         SDL_Window *window_;
@@ -63,35 +82,46 @@ namespace crust {
         int windowHeight_;
 
         Vector2 cameraPosition_;
+        Vector2 previousCameraPosition_;
         float cameraScale_;
         Box2 frustum_;
         
         bool drawEnabled_;
         bool debugDrawEnabled_;
+        bool profileDrawEnabled_;
 
         std::auto_ptr<Font> font_;
         std::auto_ptr<TextRenderer> textRenderer_;
 
         SpriteVector sprites_;
+        SpatialHash<Sprite *> spriteHash_;
+        SpriteVector visibleSprites_;
+        int nextSpriteDrawOrder_;
         TaskVector tasks_;
 
         ShaderProgram shaderProgram_;
+        SpriteBatch spriteBatch_;
 
         Texture colorTexture_;
         FrameBuffer frameBuffer_;
 
         void initFont();
         void initShaders();
+        void initSpriteBatch();
         void initFrameBuffer();
 
-        void updateFrustum();
-        void drawWorld();
+        void updateFrustum(float alpha);
+        void updateSpriteHash();
+        void findVisibleSprites();
+        void drawWorld(float alpha);
         void drawHud();
         void drawMode();
         void drawFps();
+        void drawSpriteCount();
+        void drawProfile();
         void setWorldProjection();
         void setPixelProjection();
-        void drawSprites();
+        void drawSprites(float alpha);
     };
 }
 
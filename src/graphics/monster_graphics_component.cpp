@@ -12,6 +12,7 @@
 
 namespace crust {
     MonsterGraphicsComponent::MonsterGraphicsComponent(Actor *actor) :
+        Component(componentType),
         actor_(actor),
         controlComponent_(convert(actor->getControlComponent())),
         physicsComponent_(convert(actor->getPhysicsComponent())),
@@ -15,6 +15,8 @@ namespace crust {
 
     class MonsterGraphicsComponent : public Component, public Task {
     public:
+        static Type const componentType = MONSTER_GRAPHICS_TYPE;
+
         explicit MonsterGraphicsComponent(Actor *actor);
         ~MonsterGraphicsComponent();
 
@@ -1,19 +1,21 @@
 #include "shader_factory.hpp"
 
+#include "asset_pack.hpp"
 #include "error.hpp"
 #include "scoped_handle.hpp"
 
-#include <fstream>
 #include <iostream>
 #include <sstream>
 
 namespace crust {
-    GLuint ShaderFactory::compileShader(GLenum type, char const *file)
+    GLuint ShaderFactory::compileShader(GLenum type, char const *name,
+                                        Asset const &source)
     {
-        GLchar const *source = loadSource(file);
+        GLchar const *data = reinterpret_cast<GLchar const *>(source.data);
+        GLint size = GLint(source.size);
         GLuint shader = glCreateShader(type);
         ScopedHandle<GLuint> scopedShader(shader, glDeleteShader);
-        glShaderSource(shader, 1, &source, 0);
+        glShaderSource(shader, 1, &data, &size);
         glCompileShader(shader);
         GLint compileStatus = GL_FALSE;
         glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
@@ -21,7 +23,7 @@ namespace crust {
             std::cerr << getShaderInfoLog(shader) << std::endl;
 
             std::stringstream message;
-            message << "Failed to compile shader from file: " << file;
+            message << "Failed to compile shader: " << name;
             throw Error(message.str());            
         }
         return scopedShader.release();
@@ -51,28 +53,6 @@ namespace crust {
         return scopedProgram.release();
     }
 
-    GLchar const *ShaderFactory::loadSource(char const *file)
-    {
-        std::ifstream stream(file);
-        if (!stream.is_open()) {
-            std::stringstream message;
-            message << "Failed to open shader file: " << file;
-            throw Error(message.str());
-        }
-        stream.seekg(0, std::ifstream::end);
-        std::size_t size(stream.tellg());        
-        stream.seekg(0, std::ifstream::beg);
-        buffer_.resize(size + 1);
-        stream.read(&buffer_.front(), size);
-        if (std::size_t(stream.tellg()) != size) {
-            std::stringstream message;
-            message << "Failed to read shader file: " << file;
-            throw Error(message.str());
-        }
-        buffer_.back() = 0;
-        return reinterpret_cast<GLchar const *>(&buffer_.front());
-    }
-
     GLchar const *ShaderFactory::getShaderInfoLog(GLuint shader)
     {
         GLint length = 0;
@@ -12,10 +12,12 @@ namespace crust {
     {
         ShaderFactory factory;
         if (vertexShaderHandle_ == 0) {
-            vertexShaderHandle_ = factory.compileShader(GL_VERTEX_SHADER, vertexShaderPath_.c_str());
+            vertexShaderHandle_ = factory.compileShader(GL_VERTEX_SHADER, vertexShaderName_.c_str(),
+                                                        vertexShaderSource_);
         }
         if (fragmentShaderHandle_ == 0) {
-            fragmentShaderHandle_ = factory.compileShader(GL_FRAGMENT_SHADER, fragmentShaderPath_.c_str());
+            fragmentShaderHandle_ = factory.compileShader(GL_FRAGMENT_SHADER, fragmentShaderName_.c_str(),
+                                                          fragmentShaderSource_);
         }
         if (programHandle_ == 0) {
             programHandle_ = factory.linkProgram(vertexShaderHandle_, fragmentShaderHandle_);
@@ -1,6 +1,8 @@
 #ifndef CRUST_SHADER_PROGRAM_HPP
 #define CRUST_SHADER_PROGRAM_HPP
 
+#include "asset_pack.hpp"
+
 #include <string>
 #include <SDL/SDL_opengl.h>
 
@@ -15,24 +17,17 @@ namespace crust {
         
         ~ShaderProgram();
 
-        char const *getVertexShaderPath() const
-        {
-            return vertexShaderPath_.c_str();
-        }
-
-        void setVertexShaderPath(char const *path)
-        {
-            vertexShaderPath_.assign(path);
-        }
-
-        char const *getFragmentShaderPath() const
+        // The source is read in place, and must outlive the program.
+        void setVertexShader(char const *name, Asset const &source)
         {
-            return fragmentShaderPath_.c_str();
+            vertexShaderName_.assign(name);
+            vertexShaderSource_ = source;
         }
 
-        void setFragmentShaderPath(char const *path)
+        void setFragmentShader(char const *name, Asset const &source)
         {
-            fragmentShaderPath_.assign(path);
+            fragmentShaderName_.assign(name);
+            fragmentShaderSource_ = source;
         }
 
         void create();
@@ -60,6 +55,11 @@ namespace crust {
             return glGetUniformLocation(programHandle_, name);
         }
         
+        GLint getAttribLocation(GLchar const *name)
+        {
+            return glGetAttribLocation(programHandle_, name);
+        }
+
         void setUniform(GLint location, GLint value)
         {
             glUniform1i(location, value);
@@ -83,8 +83,10 @@ namespace crust {
         }
         
     private:
-        std::string vertexShaderPath_;
-        std::string fragmentShaderPath_;
+        std::string vertexShaderName_;
+        Asset vertexShaderSource_;
+        std::string fragmentShaderName_;
+        Asset fragmentShaderSource_;
 
         GLuint vertexShaderHandle_;
         GLuint fragmentShaderHandle_;
@@ -1,158 +1,416 @@
 #include "sprite.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <SDL/SDL_opengl.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace crust {
+    namespace {
+        // Shadow pixels have twice the resolution of the color pixels. Each
+        // shadow pixel takes two samples in each direction. For an even
+        // shadow pixel, both samples hit the same color pixel, and for an
+        // odd one, they hit two neighbors. A row of shadow pixels therefore
+        // interleaves the color pixels with their neighbor pairs. The shadow
+        // is the largest alpha among the samples if any of them is
+        // transparent, or zero otherwise.
+        void getRawShadowRow(unsigned char const *alphaRow1,
+                             unsigned char const *alphaRow2,
+                             int pairCount, unsigned char *result)
+        {
+            int i = 0;
+#ifdef __SSE2__
+            __m128i zero = _mm_setzero_si128();
+            for (; i + 16 <= pairCount; i += 16) {
+                __m128i a1 = _mm_loadu_si128((__m128i const *) (alphaRow1 + i));
+                __m128i a2 = _mm_loadu_si128((__m128i const *) (alphaRow1 + i + 1));
+                __m128i b1 = _mm_loadu_si128((__m128i const *) (alphaRow2 + i));
+                __m128i b2 = _mm_loadu_si128((__m128i const *) (alphaRow2 + i + 1));
+                __m128i min1 = _mm_min_epu8(a1, b1);
+                __m128i max1 = _mm_max_epu8(a1, b1);
+                __m128i min2 = _mm_min_epu8(min1, _mm_min_epu8(a2, b2));
+                __m128i max2 = _mm_max_epu8(max1, _mm_max_epu8(a2, b2));
+                __m128i even = _mm_and_si128(_mm_cmpeq_epi8(min1, zero), max1);
+                __m128i odd = _mm_and_si128(_mm_cmpeq_epi8(min2, zero), max2);
+                _mm_storeu_si128((__m128i *) (result + 2 * i),
+                                 _mm_unpacklo_epi8(even, odd));
+                _mm_storeu_si128((__m128i *) (result + 2 * i + 16),
+                                 _mm_unpackhi_epi8(even, odd));
+            }
+#endif
+            for (; i < pairCount; ++i) {
+                unsigned char min1 = std::min(alphaRow1[i], alphaRow2[i]);
+                unsigned char max1 = std::max(alphaRow1[i], alphaRow2[i]);
+                unsigned char min2 = std::min(min1, std::min(alphaRow1[i + 1],
+                                                             alphaRow2[i + 1]));
+                unsigned char max2 = std::max(max1, std::max(alphaRow1[i + 1],
+                                                             alphaRow2[i + 1]));
+                result[2 * i] = min1 ? 0 : max1;
+                result[2 * i + 1] = min2 ? 0 : max2;
+            }
+        }
+
+        // Height of each shadow pixel as the average alpha of its samples,
+        // interleaved like the raw shadow.
+        void getHeightRow(unsigned char const *alphaRow1,
+                          unsigned char const *alphaRow2,
+                          int pairCount, unsigned char *result)
+        {
+            int i = 0;
+#ifdef __SSE2__
+            for (; i + 16 <= pairCount; i += 16) {
+                __m128i a1 = _mm_loadu_si128((__m128i const *) (alphaRow1 + i));
+                __m128i a2 = _mm_loadu_si128((__m128i const *) (alphaRow1 + i + 1));
+                __m128i b1 = _mm_loadu_si128((__m128i const *) (alphaRow2 + i));
+                __m128i b2 = _mm_loadu_si128((__m128i const *) (alphaRow2 + i + 1));
+                __m128i even = _mm_avg_epu8(a1, b1);
+                __m128i odd = _mm_avg_epu8(even, _mm_avg_epu8(a2, b2));
+                _mm_storeu_si128((__m128i *) (result + 2 * i),
+                                 _mm_unpacklo_epi8(even, odd));
+                _mm_storeu_si128((__m128i *) (result + 2 * i + 16),
+                                 _mm_unpackhi_epi8(even, odd));
+            }
+#endif
+            for (; i < pairCount; ++i) {
+                int even = (alphaRow1[i] + alphaRow2[i] + 1) >> 1;
+                int next = (alphaRow1[i + 1] + alphaRow2[i + 1] + 1) >> 1;
+                result[2 * i] = (unsigned char) even;
+                result[2 * i + 1] = (unsigned char) ((even + next + 1) >> 1);
+            }
+        }
+
+        // Sobel gradient of the heights, mapped to a normal component from 1
+        // to 127 with 64 for a flat surface. The rows are read from one
+        // before to one after the size.
+        void getNormalRows(unsigned char const *row1, unsigned char const *row2,
+                           unsigned char const *row3, int size,
+                           unsigned char *xResult, unsigned char *yResult)
+        {
+            int const scale = -4047;
+            int i = 0;
+#ifdef __SSE2__
+            __m128i zero = _mm_setzero_si128();
+            __m128i scales = _mm_set1_epi16(short(scale));
+            __m128i offsets = _mm_set1_epi16(64);
+            for (; i + 8 <= size; i += 8) {
+                __m128i a[3];
+                __m128i b[3];
+                __m128i c[3];
+                for (int j = 0; j < 3; ++j) {
+                    a[j] = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const *) (row1 + i + j - 1)), zero);
+                    b[j] = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const *) (row2 + i + j - 1)), zero);
+                    c[j] = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const *) (row3 + i + j - 1)), zero);
+                }
+                __m128i left = _mm_add_epi16(_mm_add_epi16(a[0], c[0]),
+                                             _mm_add_epi16(b[0], b[0]));
+                __m128i right = _mm_add_epi16(_mm_add_epi16(a[2], c[2]),
+                                              _mm_add_epi16(b[2], b[2]));
+                __m128i top = _mm_add_epi16(_mm_add_epi16(a[0], a[2]),
+                                            _mm_add_epi16(a[1], a[1]));
+                __m128i bottom = _mm_add_epi16(_mm_add_epi16(c[0], c[2]),
+                                               _mm_add_epi16(c[1], c[1]));
+                __m128i dx = _mm_sub_epi16(right, left);
+                __m128i dy = _mm_sub_epi16(bottom, top);
+                __m128i x = _mm_add_epi16(_mm_mulhi_epi16(dx, scales), offsets);
+                __m128i y = _mm_add_epi16(_mm_mulhi_epi16(dy, scales), offsets);
+                _mm_storel_epi64((__m128i *) (xResult + i), _mm_packus_epi16(x, x));
+                _mm_storel_epi64((__m128i *) (yResult + i), _mm_packus_epi16(y, y));
+            }
+#endif
+            for (; i < size; ++i) {
+                int dx = ((row1[i + 1] + 2 * row2[i + 1] + row3[i + 1]) -
+                          (row1[i - 1] + 2 * row2[i - 1] + row3[i - 1]));
+                int dy = ((row3[i - 1] + 2 * row3[i] + row3[i + 1]) -
+                          (row1[i - 1] + 2 * row1[i] + row1[i + 1]));
+                xResult[i] = (unsigned char) (((dx * scale) >> 16) + 64);
+                yResult[i] = (unsigned char) (((dy * scale) >> 16) + 64);
+            }
+        }
+
+        void getMaxRow(unsigned char const *row1, unsigned char const *row2,
+                       int size, unsigned char *result)
+        {
+            int i = 0;
+#ifdef __SSE2__
+            for (; i + 16 <= size; i += 16) {
+                __m128i a = _mm_loadu_si128((__m128i const *) (row1 + i));
+                __m128i b = _mm_loadu_si128((__m128i const *) (row2 + i));
+                _mm_storeu_si128((__m128i *) (result + i), _mm_max_epu8(a, b));
+            }
+#endif
+            for (; i < size; ++i) {
+                result[i] = std::max(row1[i], row2[i]);
+            }
+        }
+
+        void getMaxRow(unsigned char const *row1, unsigned char const *row2,
+                       unsigned char const *row3, int size,
+                       unsigned char *result)
+        {
+            int i = 0;
+#ifdef __SSE2__
+            for (; i + 16 <= size; i += 16) {
+                __m128i a = _mm_loadu_si128((__m128i const *) (row1 + i));
+                __m128i b = _mm_loadu_si128((__m128i const *) (row2 + i));
+                __m128i c = _mm_loadu_si128((__m128i const *) (row3 + i));
+                _mm_storeu_si128((__m128i *) (result + i),
+                                 _mm_max_epu8(_mm_max_epu8(a, b), c));
+            }
+#endif
+            for (; i < size; ++i) {
+                result[i] = std::max(std::max(row1[i], row2[i]), row3[i]);
+            }
+        }
+
+        void initShadowTable(float weight, GLbyte *table)
+        {
+            for (int i = 0; i < 256; ++i) {
+                float shadow = weight * (float(i) / 255.0f);
+                table[i] = GLbyte(std::min(127, int(shadow * 128.0)));
+            }
+        }
+    }
+
+    ShadowBuffers::ShadowBuffers()
+    {
+        initShadowTable(1.0f, centerTable);
+        initShadowTable(0.5f, edgeTable);
+        initShadowTable(0.3f, cornerTable);
+    }
+
     Sprite::Sprite() :
         angle_(0.0f),
+        previousAngle_(0.0f),
+        stateSaved_(false),
+        previousStateValid_(false),
         scale_(1.0f),
         color_(255),
 
         pixels_(Color4(0, 0)),
 
+        boundsDirty_(true),
+        drawOrder_(0),
+
         texturesDirty_(true),
-        arraysDirty_(true)
+        arraysDirty_(true),
+        arrayAngle_(0.0f)
     { }
 
-    void Sprite::draw() const
+    void Sprite::updateArrays(float alpha) const
     {
-        updateTextures();
-        updateArrays();
-
-        glActiveTexture(GL_TEXTURE0);
-        colorTexture_.bind();
-        glActiveTexture(GL_TEXTURE1);
-        normalAndShadowTexture_.bind();
-
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glVertexPointer(2, GL_FLOAT, 0, vertexArray_);
-        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        glTexCoordPointer(2, GL_FLOAT, 0, texCoordArray_);
-        glEnableClientState(GL_COLOR_ARRAY);
-        glColorPointer(4, GL_UNSIGNED_BYTE, 0, colorArray_);
-
-        glDrawArrays(GL_QUADS, 0, 4);
-
-        glDisableClientState(GL_COLOR_ARRAY);
-        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-        glDisableClientState(GL_VERTEX_ARRAY);
-        
-        glActiveTexture(GL_TEXTURE1);
-        normalAndShadowTexture_.unbind();
-        glActiveTexture(GL_TEXTURE0);
-        colorTexture_.unbind();
+        if (previousStateValid_) {
+            updateArrays(mix(previousPosition_, position_, alpha),
+                         mix(previousAngle_, angle_, alpha));
+        } else {
+            updateArrays(position_, angle_);
+        }
     }
-    
-    void Sprite::updateTextures() const
+
+    Circle2 Sprite::getBounds() const
     {
-        if (texturesDirty_) {
-            updateColorTexture();
-            updateNormalAndShadowTexture();
-            texturesDirty_ = false;
+        // The corners of the quad relative to the position. Rotation does
+        // not change their distance from it.
+        float x1 = float(pixels_.getX() - 1);
+        float y1 = float(pixels_.getY() - 1);
+        float x2 = float(pixels_.getX() + pixels_.getWidth() + 1);
+        float y2 = float(pixels_.getY() + pixels_.getHeight() + 1);
+        Vector2 offset = Vector2(-0.5f) - anchor_;
+        Vector2 corners[] = {
+            Vector2(x1, y1),
+            Vector2(x2, y1),
+            Vector2(x2, y2),
+            Vector2(x1, y2)
+        };
+        float radius = 0.0f;
+        for (int i = 0; i < 4; ++i) {
+            Vector2 corner = corners[i] + offset;
+            corner.x *= scale_.x;
+            corner.y *= scale_.y;
+            radius = std::max(radius, corner.getLength());
+        }
+
+        if (previousStateValid_) {
+            Vector2 center = mix(previousPosition_, position_, 0.5f);
+            return Circle2(center, radius + getDistance(center, position_));
+        } else {
+            return Circle2(position_, radius);
         }
     }
 
-    void Sprite::updateColorTexture() const
+    void Sprite::setPixel(int x, int y, Color4 const &color)
     {
-        colorTexture_.destroy();
+        int oldX = pixels_.getX();
+        int oldY = pixels_.getY();
+        int oldWidth = pixels_.getWidth();
+        int oldHeight = pixels_.getHeight();
+        pixels_.setElement(x, y, color);
+        if (pixels_.getX() != oldX || pixels_.getY() != oldY ||
+            pixels_.getWidth() != oldWidth || pixels_.getHeight() != oldHeight)
+        {
+            size_.x = pixels_.getWidth() + 4;
+            size_.y = pixels_.getHeight() + 4;
+            texturesDirty_ = true;
+            arraysDirty_ = true;
+            boundsDirty_ = true;
+        } else {
+            dirtyBox_.mergePoint(IntVector2(x, y));
+        }
+    }
 
-        int x = pixels_.getX();
-        int y = pixels_.getY();
+    void Sprite::getDirtyTextureBoxes(IntBox2 *colorBox,
+                                      IntBox2 *normalAndShadowBox) const
+    {
         int width = pixels_.getWidth();
         int height = pixels_.getHeight();
-        
-        std::vector<GLubyte> pixels;
-        for (int dy = -2; dy < height + 2; ++dy) {
-            for (int dx = -2; dx < width + 2; ++dx) {
-                Color4 color = pixels_.getElement(x + dx, y + dy);
+        if (texturesDirty_) {
+            *colorBox = IntBox2(IntVector2(0, 0),
+                                IntVector2(width + 4, height + 4));
+            *normalAndShadowBox = IntBox2(IntVector2(0, 0),
+                                          IntVector2(2 * width + 8, 2 * height + 8));
+        } else if (dirtyBox_.isEmpty()) {
+            *colorBox = IntBox2();
+            *normalAndShadowBox = IntBox2();
+        } else {
+            IntVector2 origin(pixels_.getX() - 2, pixels_.getY() - 2);
+            *colorBox = IntBox2(dirtyBox_.p1 - origin, dirtyBox_.p2 - origin);
+
+            // A color pixel affects the raw shadow of three shadow pixels
+            // in each direction, and smoothing spreads it one pixel further.
+            IntBox2 box(2 * colorBox->p1 - IntVector2(2, 2),
+                        2 * colorBox->p2 + IntVector2(2, 2));
+            *normalAndShadowBox = IntBox2(IntVector2(std::max(box.p1.x, 0),
+                                                     std::max(box.p1.y, 0)),
+                                          IntVector2(std::min(box.p2.x, 2 * width + 8),
+                                                     std::min(box.p2.y, 2 * height + 8)));
+        }
+    }
+
+    // Premultiplied color pixels with a transparent border of two pixels.
+    void Sprite::getColorPixels(IntBox2 const &box,
+                                std::vector<GLubyte> *result) const
+    {
+        int x = pixels_.getX() - 2;
+        int y = pixels_.getY() - 2;
+
+        std::vector<GLubyte> &pixels = *result;
+        pixels.clear();
+        for (int ty = box.p1.y; ty < box.p2.y; ++ty) {
+            for (int tx = box.p1.x; tx < box.p2.x; ++tx) {
+                Color4 color = pixels_.getElement(x + tx, y + ty);
                 pixels.push_back(color.red * color.alpha / 255);
                 pixels.push_back(color.green * color.alpha / 255);
                 pixels.push_back(color.blue * color.alpha / 255);
                 pixels.push_back(color.alpha);
             }
         }
-
-        colorTexture_.setInternalFormat(GL_SRGB_ALPHA);
-        colorTexture_.setSize(width + 4, height + 4);
-        colorTexture_.setPixels(&pixels.front(), pixels.size());
-        colorTexture_.create();
     }
 
-    void Sprite::updateNormalAndShadowTexture() const
+    // Normal and shadow pixels at twice the resolution of the color pixels,
+    // with a border of four pixels. The normals are taken from the alpha as
+    // a height field, and their x and y components are stored with a bias
+    // of 64.
+    void Sprite::getNormalAndShadowPixels(IntBox2 const &box,
+                                          ShadowBuffers *buffers,
+                                          std::vector<GLbyte> *result) const
     {
-        normalAndShadowTexture_.destroy();
+        // Raw shadow for the box and a border of one pixel, starting at an
+        // even shadow pixel.
+        int rawX = (box.p1.x - 1) & ~1;
+        int rawY = box.p1.y - 1;
+        int pairCount = (box.p2.x + 2 - rawX) / 2;
+        int rawWidth = 2 * pairCount;
+        int rawHeight = box.getHeight() + 2;
 
-        int x = pixels_.getX();
-        int y = pixels_.getY();
-        int width = pixels_.getWidth();
-        int height = pixels_.getHeight();
-        
-        std::vector<float> shadowData;
-        for (int dy = -4; dy < 2 * height + 4; ++dy) {
-            for (int dx = -4; dx < 2 * width + 4; ++dx) {
-                float minShadow = 1.0f;
-                float maxShadow = 0.0f;
-                Vector2 position = Vector2(0.5f * float(dx), 0.5f * float(dy));
-                for (int ddy = 0; ddy < 2; ++ddy) {
-                    for (int ddx = 0; ddx < 2; ++ddx) {
-                        Vector2 samplePosition = position + Vector2(0.5f * float(ddx) - 0.25f, 0.5f * float(ddy) - 0.25f);
-                        float alpha = float(pixels_.getElement(x + int(samplePosition.x + 1.5f) - 1,
-                                                               y + int(samplePosition.y + 1.5f) - 1).alpha) / 255.0f;
-                        minShadow = std::min(minShadow, alpha);
-                        maxShadow = std::max(maxShadow, alpha);
-                    }
-                }
-                shadowData.push_back(minShadow < 0.001f ? maxShadow : 0.0f);
+        // Alpha of the color pixels under the raw shadow. Relies on
+        // arithmetic shifts for the negative shadow coordinates.
+        int alphaRow = (rawY - 4) >> 1;
+        int alphaX = pixels_.getX() + (rawX >> 1) - 2;
+        int alphaY = pixels_.getY() + alphaRow;
+        int alphaWidth = pairCount + 1;
+        int alphaHeight = ((rawY + rawHeight - 4) >> 1) - alphaRow + 1;
+        std::vector<unsigned char> &alpha = buffers->alpha;
+        alpha.assign(alphaWidth * alphaHeight, 0);
+        int x1 = std::max(alphaX, pixels_.getX());
+        int y1 = std::max(alphaY, pixels_.getY());
+        int x2 = std::min(alphaX + alphaWidth, pixels_.getX() + pixels_.getWidth());
+        int y2 = std::min(alphaY + alphaHeight, pixels_.getY() + pixels_.getHeight());
+        for (int y = y1; y < y2; ++y) {
+            for (int x = x1; x < x2; ++x) {
+                alpha[(y - alphaY) * alphaWidth + x - alphaX] = pixels_.getElement(x, y).alpha;
             }
         }
-        
-        std::vector<float> smoothShadowData(shadowData.size(), 0.0f);
-        int pitch = 2 * width + 8;
-        for (int dy = 2; dy < 2 * height + 8 - 2; ++dy) {
-            for (int dx = 2; dx < 2 * width + 8 - 2; ++dx) {
-                float shadow = shadowData[dy * pitch + dx];
-                if (0.001f < shadow) {
-                    smoothShadowData[dy * pitch + dx] = std::max(shadow, smoothShadowData[dy * pitch + dx]);
-                    
-                    smoothShadowData[dy * pitch + dx + 1] = std::max(0.5f * shadow, smoothShadowData[dy * pitch + dx + 1]);
-                    smoothShadowData[dy * pitch + dx - 1] = std::max(0.5f * shadow, smoothShadowData[dy * pitch + dx - 1]);
-                    smoothShadowData[(dy + 1) * pitch + dx] = std::max(0.5f * shadow, smoothShadowData[(dy + 1) * pitch + dx]);
-                    smoothShadowData[(dy - 1) * pitch + dx] = std::max(0.5f * shadow, smoothShadowData[(dy - 1) * pitch + dx]);
-                    
-                    smoothShadowData[(dy - 1) * pitch + dx - 1] = std::max(0.3f * shadow, smoothShadowData[(dy - 1) * pitch + dx - 1]);
-                    smoothShadowData[(dy - 1) * pitch + dx + 1] = std::max(0.3f * shadow, smoothShadowData[(dy - 1) * pitch + dx + 1]);
-                    smoothShadowData[(dy + 1) * pitch + dx + 1] = std::max(0.3f * shadow, smoothShadowData[(dy + 1) * pitch + dx + 1]);
-                    smoothShadowData[(dy + 1) * pitch + dx - 1] = std::max(0.3f * shadow, smoothShadowData[(dy + 1) * pitch + dx - 1]);
-                }
-            }
+
+        std::vector<unsigned char> &heights = buffers->heights;
+        std::vector<unsigned char> &raw = buffers->raw;
+        heights.resize(rawWidth * rawHeight);
+        raw.resize(rawWidth * rawHeight);
+        for (int ry = 0; ry < rawHeight; ++ry) {
+            int sy = rawY + ry;
+            unsigned char const *alphaRow1 = &alpha[(((sy - 4) >> 1) - alphaRow) * alphaWidth];
+            unsigned char const *alphaRow2 = &alpha[(((sy - 3) >> 1) - alphaRow) * alphaWidth];
+            getHeightRow(alphaRow1, alphaRow2, pairCount, &heights[ry * rawWidth]);
+            getRawShadowRow(alphaRow1, alphaRow2, pairCount, &raw[ry * rawWidth]);
         }
-        
-        std::vector<GLbyte> pixels(4 * smoothShadowData.size());
-        for (std::size_t i = 0; i < smoothShadowData.size(); ++i) {
-            pixels[4 * i + 0] = 0;
-            pixels[4 * i + 1] = 0;
-            pixels[4 * i + 2] = 127;
-            pixels[4 * i + 3] = std::min(127, int(smoothShadowData[i] * 128.0));
+
+        // Smooth by taking the largest weighted shadow of the neighbors. The
+        // left and right neighbors are combined once per row, and reused for
+        // the edges of the current row and the corners of the rows above
+        // and below.
+        int width = box.getWidth();
+        int height = box.getHeight();
+        int offset = box.p1.x - rawX;
+        std::vector<unsigned char> &sides = buffers->sides;
+        sides.resize(width * rawHeight);
+        for (int ry = 0; ry < rawHeight; ++ry) {
+            unsigned char const *rawRow = &raw[ry * rawWidth + offset];
+            getMaxRow(rawRow - 1, rawRow + 1, width, &sides[ry * width]);
+        }
+        std::vector<unsigned char> &edges = buffers->edges;
+        std::vector<unsigned char> &corners = buffers->corners;
+        std::vector<unsigned char> &xNormals = buffers->xNormals;
+        std::vector<unsigned char> &yNormals = buffers->yNormals;
+        edges.resize(width);
+        corners.resize(width);
+        xNormals.resize(width);
+        yNormals.resize(width);
+        std::vector<GLbyte> &pixels = *result;
+        pixels.resize(4 * width * height);
+        for (int y = 0; y < height; ++y) {
+            unsigned char const *center = &raw[(y + 1) * rawWidth + offset];
+            getMaxRow(&sides[(y + 1) * width], center - rawWidth,
+                      center + rawWidth, width, &edges.front());
+            getMaxRow(&sides[y * width], &sides[(y + 2) * width], width,
+                      &corners.front());
+            unsigned char const *height = &heights[(y + 1) * rawWidth + offset];
+            getNormalRows(height - rawWidth, height, height + rawWidth, width,
+                          &xNormals.front(), &yNormals.front());
+            for (int x = 0; x < width; ++x) {
+                GLbyte *pixel = &pixels[4 * (y * width + x)];
+                pixel[0] = GLbyte(xNormals[x]);
+                pixel[1] = GLbyte(yNormals[x]);
+                pixel[2] = 127;
+                pixel[3] = std::max(buffers->centerTable[center[x]],
+                                    std::max(buffers->edgeTable[edges[x]],
+                                             buffers->cornerTable[corners[x]]));
+            }
         }
-        
-        normalAndShadowTexture_.setInternalFormat(GL_SRGB_ALPHA);
-        normalAndShadowTexture_.setSize(2 * (width + 4), 2 * (height + 4));
-        normalAndShadowTexture_.setType(GL_BYTE);
-        normalAndShadowTexture_.setPixels(&pixels.front(), pixels.size());
-        normalAndShadowTexture_.create();
     }
     
-    void Sprite::updateArrays() const
+    void Sprite::updateArrays(Vector2 const &position, float angle) const
     {
-        if (!arraysDirty_) {
+        if (!arraysDirty_ && position.x == arrayPosition_.x &&
+            position.y == arrayPosition_.y && angle == arrayAngle_)
+        {
             return;
         }
 
         Matrix3 transform;
-        transform.translate(position_);
-        transform.rotate(angle_);
+        transform.translate(position);
+        transform.rotate(angle);
         transform.scale(scale_);
         transform.translate(Vector2(-0.5f) - anchor_);
 
@@ -193,6 +451,8 @@ namespace crust {
             colorArray_[i * 4 + 3] = color_.alpha;
         }
 
+        arrayPosition_ = position;
+        arrayAngle_ = angle;
         arraysDirty_ = false;
     }
 }
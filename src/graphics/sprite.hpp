@@ -3,13 +3,35 @@
 
 #include "color.hpp"
 #include "geometry.hpp"
-#include "grid.hpp"
+#include "chunked_grid.hpp"
 #include "int_geometry.hpp"
-#include "texture.hpp"
+#include "sprite_atlas.hpp"
 
+#include <vector>
 #include <SDL/SDL_opengl.h>
 
 namespace crust {
+    // Scratch rows for Sprite::getNormalAndShadowPixels, kept by the caller
+    // so that they are not reallocated for every sprite. Also holds the
+    // tables that map a shadow to a weighted texel value.
+    class ShadowBuffers {
+    public:
+        std::vector<unsigned char> alpha;
+        std::vector<unsigned char> heights;
+        std::vector<unsigned char> raw;
+        std::vector<unsigned char> sides;
+        std::vector<unsigned char> edges;
+        std::vector<unsigned char> corners;
+        std::vector<unsigned char> xNormals;
+        std::vector<unsigned char> yNormals;
+
+        GLbyte centerTable[256];
+        GLbyte edgeTable[256];
+        GLbyte cornerTable[256];
+
+        ShadowBuffers();
+    };
+
     class Sprite {
     public:
         Sprite();
@@ -26,8 +48,11 @@ namespace crust {
 
         void setPosition(Vector2 const &position)
         {
-            position_ = position;
-            arraysDirty_ = true;
+            if (position.x != position_.x || position.y != position_.y) {
+                position_ = position;
+                arraysDirty_ = true;
+                boundsDirty_ = true;
+            }
         }
 
         float getAngle() const
@@ -50,6 +75,7 @@ namespace crust {
         {
             scale_ = scale;
             arraysDirty_ = true;
+            boundsDirty_ = true;
         }
 
         Color4 const &getColor() const
@@ -72,43 +98,141 @@ namespace crust {
         {
             anchor_ = anchor;
             arraysDirty_ = true;
+            boundsDirty_ = true;
         }
 
-        void setPixel(int x, int y, Color4 const &color)
+        Color4 const &getPixel(int x, int y) const
         {
-            pixels_.setElement(x, y, color);
-            size_.x = pixels_.getWidth() + 4;
-            size_.y = pixels_.getHeight() + 4;
-            texturesDirty_ = true;
-            arraysDirty_ = true;
+            return pixels_.getElement(x, y);
         }
+
+        void setPixel(int x, int y, Color4 const &color);
         
-        void draw() const;
+        // Remember the current position and angle, so that drawing can
+        // interpolate between them and the ones set during the next step.
+        void saveState()
+        {
+            if (previousPosition_.x != position_.x ||
+                previousPosition_.y != position_.y)
+            {
+                boundsDirty_ = true;
+            }
+            previousPosition_ = position_;
+            previousAngle_ = angle_;
+            previousStateValid_ = stateSaved_;
+            stateSaved_ = true;
+        }
+
+        // World bounds covering the sprite at both the previous and the
+        // current position, so that they hold for any interpolated draw.
+        Circle2 getBounds() const;
+
+        // Set whenever the bounds may have changed.
+        bool isBoundsDirty() const
+        {
+            return boundsDirty_;
+        }
+
+        void setBoundsDirty(bool dirty)
+        {
+            boundsDirty_ = dirty;
+        }
+
+        // Sprites are drawn in increasing order.
+        int getDrawOrder() const
+        {
+            return drawOrder_;
+        }
+
+        void setDrawOrder(int order)
+        {
+            drawOrder_ = order;
+        }
+
+        // Set whenever the pixels have changed since they were last copied
+        // to the atlas. Edits that keep the bounds of the pixel grid only
+        // dirty the edited rectangle.
+        bool isTexturesDirty() const
+        {
+            return texturesDirty_ || !dirtyBox_.isEmpty();
+        }
+
+        // Marks the whole textures as dirty, or all of them as clean.
+        void setTexturesDirty(bool dirty)
+        {
+            texturesDirty_ = dirty;
+            dirtyBox_ = IntBox2();
+        }
+
+        // Rectangles of the color and the normal and shadow textures that
+        // need to be copied to the atlas.
+        void getDirtyTextureBoxes(IntBox2 *colorBox,
+                                  IntBox2 *normalAndShadowBox) const;
+
+        AtlasRegion const &getAtlasRegion() const
+        {
+            return atlasRegion_;
+        }
+
+        void setAtlasRegion(AtlasRegion const &region)
+        {
+            atlasRegion_ = region;
+        }
+
+        void getColorPixels(IntBox2 const &box,
+                            std::vector<GLubyte> *pixels) const;
+        void getNormalAndShadowPixels(IntBox2 const &box,
+                                      ShadowBuffers *buffers,
+                                      std::vector<GLbyte> *pixels) const;
+
+        // Updates the quad for a position and angle interpolated between the
+        // previous and the current state.
+        void updateArrays(float alpha) const;
+
+        GLfloat const *getVertexArray() const
+        {
+            return vertexArray_;
+        }
+
+        GLfloat const *getTexCoordArray() const
+        {
+            return texCoordArray_;
+        }
+
+        GLubyte const *getColorArray() const
+        {
+            return colorArray_;
+        }
 
     private:
         IntVector2 size_;
         Vector2 position_;
         float angle_;
+        Vector2 previousPosition_;
+        float previousAngle_;
+        bool stateSaved_;
+        bool previousStateValid_;
         Vector2 scale_;
         Color4 color_;
         Vector2 anchor_;
 
-        Grid<Color4> pixels_;
+        ChunkedGrid<Color4> pixels_;
 
-        mutable bool texturesDirty_;
-        mutable Texture colorTexture_;
-        mutable Texture normalAndShadowTexture_;
+        bool boundsDirty_;
+        int drawOrder_;
+
+        bool texturesDirty_;
+        IntBox2 dirtyBox_;
+        AtlasRegion atlasRegion_;
 
         mutable bool arraysDirty_;
+        mutable Vector2 arrayPosition_;
+        mutable float arrayAngle_;
         mutable GLfloat vertexArray_[8];
         mutable GLfloat texCoordArray_[8];
         mutable GLubyte colorArray_[16];
 
-        void updateTextures() const;
-        void updateColorTexture() const;
-        void updateNormalAndShadowTexture() const;
-
-        void updateArrays() const;
+        void updateArrays(Vector2 const &position, float angle) const;
     };
 }
 
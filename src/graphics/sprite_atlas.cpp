@@ -0,0 +1,170 @@
+#include "sprite_atlas.hpp"
+
+#include "error.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace crust {
+    SpriteAtlas::SpriteAtlas(int pageSize, int minCellSize) :
+        pageSize_(pageSize),
+        minCellSize_(minCellSize),
+        levelCount_(1)
+    {
+        while (getCellSize(levelCount_ - 1) < pageSize_) {
+            ++levelCount_;
+        }
+    }
+
+    AtlasRegion SpriteAtlas::allocate(int size)
+    {
+        int level = getLevel(size);
+        if (level >= levelCount_) {
+            std::stringstream message;
+            message << "Sprite of size " << size
+                    << " does not fit in an atlas page of size " << pageSize_;
+            throw Error(message.str());
+        }
+
+        AtlasRegion region;
+        for (int i = 0; i < int(pages_.size()); ++i) {
+            if (allocate(i, level, &region)) {
+                return region;
+            }
+        }
+        addPage();
+        allocate(int(pages_.size()) - 1, level, &region);
+        return region;
+    }
+
+    void SpriteAtlas::free(AtlasRegion const &region)
+    {
+        if (region.isNull()) {
+            return;
+        }
+
+        Page &page = pages_[region.page];
+        int level = getLevel(region.size);
+        IntVector2 cell(region.x, region.y);
+
+        // Merge the cell with its siblings for as long as they are all free.
+        while (level + 1 < levelCount_) {
+            int cellSize = getCellSize(level);
+            int parentSize = getCellSize(level + 1);
+            IntVector2 parent(cell.x - cell.x % parentSize,
+                              cell.y - cell.y % parentSize);
+            IntVector2 siblings[] = {
+                parent,
+                parent + IntVector2(cellSize, 0),
+                parent + IntVector2(0, cellSize),
+                parent + IntVector2(cellSize, cellSize)
+            };
+
+            CellVector &freeCells = page.freeCells[level];
+            int freeSiblingCount = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (siblings[i] != cell &&
+                    std::find(freeCells.begin(), freeCells.end(), siblings[i]) != freeCells.end())
+                {
+                    ++freeSiblingCount;
+                }
+            }
+            if (freeSiblingCount != 3) {
+                break;
+            }
+            for (int i = 0; i < 4; ++i) {
+                if (siblings[i] != cell) {
+                    removeCell(&freeCells, siblings[i]);
+                }
+            }
+            cell = parent;
+            ++level;
+        }
+        page.freeCells[level].push_back(cell);
+    }
+
+    void SpriteAtlas::setColorPixels(AtlasRegion const &region,
+                                     IntBox2 const &box, GLubyte const *pixels)
+    {
+        pages_[region.page].colorTexture.setSubPixels(region.x + box.p1.x,
+                                                      region.y + box.p1.y,
+                                                      box.getWidth(),
+                                                      box.getHeight(), pixels);
+    }
+
+    void SpriteAtlas::setNormalAndShadowPixels(AtlasRegion const &region,
+                                               IntBox2 const &box,
+                                               GLbyte const *pixels)
+    {
+        Texture &texture = pages_[region.page].normalAndShadowTexture;
+        texture.setSubPixels(2 * region.x + box.p1.x, 2 * region.y + box.p1.y,
+                             box.getWidth(), box.getHeight(), pixels);
+    }
+
+    int SpriteAtlas::getLevel(int size) const
+    {
+        int level = 0;
+        while (getCellSize(level) < size) {
+            ++level;
+        }
+        return level;
+    }
+
+    bool SpriteAtlas::allocate(int pageIndex, int level, AtlasRegion *region)
+    {
+        Page &page = pages_[pageIndex];
+        int freeLevel = level;
+        while (freeLevel < levelCount_ && page.freeCells[freeLevel].empty()) {
+            ++freeLevel;
+        }
+        if (freeLevel == levelCount_) {
+            return false;
+        }
+
+        IntVector2 cell = page.freeCells[freeLevel].back();
+        page.freeCells[freeLevel].pop_back();
+
+        // Split the cell until it has the requested size, keeping the lower
+        // left quarter each time.
+        for (; freeLevel > level; --freeLevel) {
+            int cellSize = getCellSize(freeLevel - 1);
+            CellVector &freeCells = page.freeCells[freeLevel - 1];
+            freeCells.push_back(cell + IntVector2(cellSize, cellSize));
+            freeCells.push_back(cell + IntVector2(0, cellSize));
+            freeCells.push_back(cell + IntVector2(cellSize, 0));
+        }
+
+        *region = AtlasRegion(pageIndex, cell.x, cell.y, getCellSize(level));
+        return true;
+    }
+
+    void SpriteAtlas::addPage()
+    {
+        std::auto_ptr<Page> page(new Page);
+
+        page->colorTexture.setInternalFormat(GL_SRGB_ALPHA);
+        page->colorTexture.setSize(pageSize_, pageSize_);
+        page->colorTexture.create();
+
+        // Linear, so that the biased normals reach the shader as stored.
+        page->normalAndShadowTexture.setInternalFormat(GL_RGBA);
+        page->normalAndShadowTexture.setSize(2 * pageSize_, 2 * pageSize_);
+        page->normalAndShadowTexture.setType(GL_BYTE);
+        page->normalAndShadowTexture.create();
+
+        page->freeCells.resize(levelCount_);
+        page->freeCells[levelCount_ - 1].push_back(IntVector2(0, 0));
+        pages_.push_back(page);
+    }
+
+    bool SpriteAtlas::removeCell(CellVector *cells, IntVector2 const &cell)
+    {
+        CellVector::iterator i = std::find(cells->begin(), cells->end(), cell);
+        if (i == cells->end()) {
+            return false;
+        }
+        *i = cells->back();
+        cells->pop_back();
+        return true;
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef CRUST_SPRITE_ATLAS_HPP
+#define CRUST_SPRITE_ATLAS_HPP
+
+#include "int_geometry.hpp"
+#include "texture.hpp"
+
+#include <vector>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <SDL/SDL_opengl.h>
+
+namespace crust {
+    // Square cell in an atlas page. The cell is at the same position in the
+    // color texture and, scaled by two, in the normal and shadow texture.
+    class AtlasRegion {
+    public:
+        int page;
+        int x;
+        int y;
+        int size;
+
+        AtlasRegion() :
+            page(-1),
+            x(0),
+            y(0),
+            size(0)
+        { }
+
+        AtlasRegion(int page, int x, int y, int size) :
+            page(page),
+            x(x),
+            y(y),
+            size(size)
+        { }
+
+        bool isNull() const
+        {
+            return page == -1;
+        }
+    };
+
+    // Packs sprite textures into pages. Cells are allocated from a quadtree
+    // of power-of-two squares, and freed cells are merged with their
+    // siblings.
+    class SpriteAtlas {
+    public:
+        explicit SpriteAtlas(int pageSize = 1024, int minCellSize = 16);
+
+        int getPageSize() const
+        {
+            return pageSize_;
+        }
+
+        int getPageCount() const
+        {
+            return int(pages_.size());
+        }
+
+        Texture *getColorTexture(int page)
+        {
+            return &pages_[page].colorTexture;
+        }
+
+        Texture *getNormalAndShadowTexture(int page)
+        {
+            return &pages_[page].normalAndShadowTexture;
+        }
+
+        AtlasRegion allocate(int size);
+        void free(AtlasRegion const &region);
+
+        // Copies pixels to a rectangle of the region. The rectangle of the
+        // normal and shadow pixels is in the coordinates of the twice as
+        // large normal and shadow texture.
+        void setColorPixels(AtlasRegion const &region, IntBox2 const &box,
+                            GLubyte const *pixels);
+        void setNormalAndShadowPixels(AtlasRegion const &region,
+                                      IntBox2 const &box,
+                                      GLbyte const *pixels);
+
+    private:
+        typedef std::vector<IntVector2> CellVector;
+
+        class Page {
+        public:
+            Texture colorTexture;
+            Texture normalAndShadowTexture;
+            std::vector<CellVector> freeCells;
+        };
+
+        typedef boost::ptr_vector<Page> PageVector;
+
+        int pageSize_;
+        int minCellSize_;
+        int levelCount_;
+        PageVector pages_;
+
+        int getCellSize(int level) const
+        {
+            return minCellSize_ << level;
+        }
+
+        int getLevel(int size) const;
+        bool allocate(int pageIndex, int level, AtlasRegion *region);
+        void addPage();
+
+        static bool removeCell(CellVector *cells, IntVector2 const &cell);
+    };
+}
+
+#endif
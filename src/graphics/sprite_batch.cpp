@@ -0,0 +1,173 @@
+#include "sprite_batch.hpp"
+
+#include "profiler.hpp"
+#include "shader_program.hpp"
+#include "sprite.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace crust {
+    SpriteBatch::SpriteBatch(Profiler *profiler) :
+        profiler_(profiler),
+        bufferHandle_(0),
+        bufferSize_(0),
+        drawCallCount_(0)
+    { }
+
+    SpriteBatch::~SpriteBatch()
+    {
+        destroy();
+    }
+
+    void SpriteBatch::create()
+    {
+        if (bufferHandle_ == 0) {
+            glGenBuffers(1, &bufferHandle_);
+            bufferSize_ = 0;
+        }
+    }
+
+    void SpriteBatch::destroy()
+    {
+        if (bufferHandle_ != 0) {
+            glDeleteBuffers(1, &bufferHandle_);
+            bufferHandle_ = 0;
+        }
+    }
+
+    void SpriteBatch::addSprite(Sprite *sprite, float alpha)
+    {
+        updateTextures(sprite);
+        sprite->updateArrays(alpha);
+
+        AtlasRegion const &region = sprite->getAtlasRegion();
+        IntVector2 const &size = sprite->getSize();
+        float invPageSize = 1.0f / float(atlas_.getPageSize());
+
+        GLfloat const *vertexArray = sprite->getVertexArray();
+        GLfloat const *texCoordArray = sprite->getTexCoordArray();
+        GLubyte const *colorArray = sprite->getColorArray();
+        for (int i = 0; i < 4; ++i) {
+            SpriteVertex vertex;
+            vertex.position[0] = vertexArray[2 * i + 0];
+            vertex.position[1] = vertexArray[2 * i + 1];
+            vertex.texCoord[0] = texCoordArray[2 * i + 0];
+            vertex.texCoord[1] = texCoordArray[2 * i + 1];
+            std::copy(colorArray + 4 * i, colorArray + 4 * i + 4, vertex.color);
+            vertex.atlasRect[0] = float(region.x) * invPageSize;
+            vertex.atlasRect[1] = float(region.y) * invPageSize;
+            vertex.atlasRect[2] = float(size.x) * invPageSize;
+            vertex.atlasRect[3] = float(size.y) * invPageSize;
+            vertex.textureSize[0] = GLfloat(size.x);
+            vertex.textureSize[1] = GLfloat(size.y);
+            vertices_.push_back(vertex);
+        }
+
+        if (runs_.empty() || runs_.back().page != region.page) {
+            runs_.push_back(Run(region.page, GLint(vertices_.size() - 4), 0));
+        }
+        runs_.back().count += 4;
+    }
+
+    void SpriteBatch::removeSprite(Sprite *sprite)
+    {
+        atlas_.free(sprite->getAtlasRegion());
+        sprite->setAtlasRegion(AtlasRegion());
+        sprite->setTexturesDirty(true);
+    }
+
+    void SpriteBatch::draw(ShaderProgram *program)
+    {
+        drawCallCount_ = 0;
+        if (vertices_.empty()) {
+            return;
+        }
+
+        // Orphan the old storage instead of waiting for draws that still
+        // use it.
+        GLsizeiptr size = GLsizeiptr(vertices_.size() * sizeof(SpriteVertex));
+        glBindBuffer(GL_ARRAY_BUFFER, bufferHandle_);
+        bufferSize_ = std::max(bufferSize_, size);
+        glBufferData(GL_ARRAY_BUFFER, bufferSize_, 0, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, &vertices_.front());
+
+        GLsizei stride = sizeof(SpriteVertex);
+        GLint atlasRectLocation = program->getAttribLocation("spriteAtlasRect");
+        GLint textureSizeLocation = program->getAttribLocation("spriteTextureSize");
+
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(2, GL_FLOAT, stride,
+                        reinterpret_cast<GLvoid const *>(offsetof(SpriteVertex, position)));
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, stride,
+                          reinterpret_cast<GLvoid const *>(offsetof(SpriteVertex, texCoord)));
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(4, GL_UNSIGNED_BYTE, stride,
+                       reinterpret_cast<GLvoid const *>(offsetof(SpriteVertex, color)));
+        glEnableVertexAttribArray(atlasRectLocation);
+        glVertexAttribPointer(atlasRectLocation, 4, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<GLvoid const *>(offsetof(SpriteVertex, atlasRect)));
+        glEnableVertexAttribArray(textureSizeLocation);
+        glVertexAttribPointer(textureSizeLocation, 2, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<GLvoid const *>(offsetof(SpriteVertex, textureSize)));
+
+        for (RunVector::iterator i = runs_.begin(); i != runs_.end(); ++i) {
+            glActiveTexture(GL_TEXTURE0);
+            atlas_.getColorTexture(i->page)->bind();
+            glActiveTexture(GL_TEXTURE1);
+            atlas_.getNormalAndShadowTexture(i->page)->bind();
+            glDrawArrays(GL_QUADS, i->first, i->count);
+            ++drawCallCount_;
+        }
+
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glDisableVertexAttribArray(textureSizeLocation);
+        glDisableVertexAttribArray(atlasRectLocation);
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        vertices_.clear();
+        runs_.clear();
+    }
+
+    void SpriteBatch::updateTextures(Sprite *sprite)
+    {
+        if (!sprite->isTexturesDirty()) {
+            return;
+        }
+        ProfileZone zone(profiler_, "UPLOAD");
+
+        // Only move the sprite to a new cell if it has outgrown the old one.
+        IntVector2 const &size = sprite->getSize();
+        AtlasRegion region = sprite->getAtlasRegion();
+        if (region.isNull() || region.size < std::max(size.x, size.y)) {
+            atlas_.free(region);
+            region = atlas_.allocate(std::max(size.x, size.y));
+            sprite->setAtlasRegion(region);
+            sprite->setTexturesDirty(true);
+        }
+
+        IntBox2 colorBox;
+        IntBox2 normalAndShadowBox;
+        sprite->getDirtyTextureBoxes(&colorBox, &normalAndShadowBox);
+        if (!colorBox.isEmpty()) {
+            sprite->getColorPixels(colorBox, &colorPixels_);
+            atlas_.setColorPixels(region, colorBox, &colorPixels_.front());
+        }
+        if (!normalAndShadowBox.isEmpty()) {
+            sprite->getNormalAndShadowPixels(normalAndShadowBox,
+                                             &shadowBuffers_,
+                                             &normalAndShadowPixels_);
+            atlas_.setNormalAndShadowPixels(region, normalAndShadowBox,
+                                            &normalAndShadowPixels_.front());
+        }
+        sprite->setTexturesDirty(false);
+    }
+}
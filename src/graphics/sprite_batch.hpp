@@ -0,0 +1,83 @@
+#ifndef CRUST_SPRITE_BATCH_HPP
+#define CRUST_SPRITE_BATCH_HPP
+
+#include "sprite.hpp"
+#include "sprite_atlas.hpp"
+
+#include <vector>
+#include <SDL/SDL_opengl.h>
+
+namespace crust {
+    class Profiler;
+    class ShaderProgram;
+
+    class SpriteVertex {
+    public:
+        GLfloat position[2];
+        GLfloat texCoord[2];
+        GLubyte color[4];
+        GLfloat atlasRect[4];
+        GLfloat textureSize[2];
+    };
+
+    // Collects the quads of the sprites drawn during a frame into a single
+    // vertex buffer. Consecutive sprites on the same atlas page are drawn
+    // with a single call.
+    class SpriteBatch {
+    public:
+        explicit SpriteBatch(Profiler *profiler = 0);
+        ~SpriteBatch();
+
+        void create();
+        void destroy();
+
+        void addSprite(Sprite *sprite, float alpha);
+
+        // Frees the atlas region of a sprite that will no longer be drawn.
+        void removeSprite(Sprite *sprite);
+
+        void draw(ShaderProgram *program);
+
+        int getDrawCallCount() const
+        {
+            return drawCallCount_;
+        }
+
+    private:
+        class Run {
+        public:
+            int page;
+            GLint first;
+            GLsizei count;
+
+            Run(int page, GLint first, GLsizei count) :
+                page(page),
+                first(first),
+                count(count)
+            { }
+        };
+
+        typedef std::vector<SpriteVertex> VertexVector;
+        typedef std::vector<Run> RunVector;
+
+        Profiler *profiler_;
+        SpriteAtlas atlas_;
+        GLuint bufferHandle_;
+        GLsizeiptr bufferSize_;
+        VertexVector vertices_;
+        RunVector runs_;
+        int drawCallCount_;
+
+        std::vector<GLubyte> colorPixels_;
+        std::vector<GLbyte> normalAndShadowPixels_;
+        ShadowBuffers shadowBuffers_;
+
+        void updateTextures(Sprite *sprite);
+
+        // Noncopyable.
+        SpriteBatch(SpriteBatch const &other);
+        SpriteBatch &operator=(SpriteBatch const &other);
+    };
+}
+
+#endif
@@ -6,67 +6,31 @@
 #include <SDL/SDL_opengl.h>
 
 namespace crust {
-    void TextRenderer::draw(char const *text)
+    TextRenderer::TextRenderer(Font *font) :
+        font_(font),
+        glyphMeshes_(256)
     {
-        int x = 0;
-        int y = 0;
-
-        float halfLineWidth = 1.0f;
-        glColor3ub(0, 0, 0);
-        glBegin(GL_QUADS);
-        for (char const *glyph = text; *glyph; ++glyph) {
-            if (glyph != text) {
-                x += 1;
-            }
-            int width = font_->getGlyphWidth(*glyph);
-            int height = font_->getGlyphHeight(*glyph);
-            for (int dy = 0; dy < height + 1; ++dy) {
-                for (int dx = 0; dx < width + 1; ++dx) {
-                    bool center = (dx < width && dy < height) && font_->getGlyphPixel(*glyph, dx, dy);
-                    bool left = (dx - 1 >= 0 && dy < height) && font_->getGlyphPixel(*glyph, dx - 1, dy);
-                    bool bottom = (dx < width && dy - 1 >= 0) && font_->getGlyphPixel(*glyph, dx, dy - 1);
-                    if (left != center) {
-                        glVertex2f(float(x + dx) - halfLineWidth, float(y + dy) - halfLineWidth);
-                        glVertex2f(float(x + dx) + halfLineWidth, float(y + dy) - halfLineWidth);
-                        glVertex2f(float(x + dx) + halfLineWidth, float(y + dy + 1) + halfLineWidth);
-                        glVertex2f(float(x + dx) - halfLineWidth, float(y + dy + 1) + halfLineWidth);
-                    }
-                    if (bottom != center) {
-                        glVertex2f(float(x + dx) - halfLineWidth, float(y + dy) - halfLineWidth);
-                        glVertex2f(float(x + dx + 1) + halfLineWidth, float(y + dy) - halfLineWidth);
-                        glVertex2f(float(x + dx + 1) + halfLineWidth, float(y + dy) + halfLineWidth);
-                        glVertex2f(float(x + dx) - halfLineWidth, float(y + dy) + halfLineWidth);
-                    }
-                }
-            }
-            x += width;
+        for (int i = 0; i < 256; ++i) {
+            initGlyphMesh(char(i), &glyphMeshes_[i]);
         }
-        glEnd();
+    }
 
-        x = 0;
-        y = 0;
+    void TextRenderer::draw(char const *text)
+    {
+        TextBuffer *buffer = getTextBuffer(text);
+        if (buffer->outlineCount + buffer->fillCount == 0) {
+            return;
+        }
 
+        glBindBuffer(GL_ARRAY_BUFFER, buffer->bufferHandle);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 0, 0);
+        glColor3ub(0, 0, 0);
+        glDrawArrays(GL_QUADS, 0, buffer->outlineCount);
         glColor3ub(255, 255, 255);
-        glBegin(GL_QUADS);
-        for (char const *glyph = text; *glyph; ++glyph) {
-            if (glyph != text) {
-                x += 1;
-            }
-            int width = font_->getGlyphWidth(*glyph);
-            int height = font_->getGlyphHeight(*glyph);
-            for (int dy = 0; dy < height; ++dy) {
-                for (int dx = 0; dx < width; ++dx) {
-                    if (font_->getGlyphPixel(*glyph, dx, dy)) {
-                        glVertex2i(x + dx, y + dy);
-                        glVertex2i(x + dx + 1, y + dy);
-                        glVertex2i(x + dx + 1, y + dy + 1);
-                        glVertex2i(x + dx, y + dy + 1);
-                    }
-                }
-            }
-            x += width;
-        }
-        glEnd();
+        glDrawArrays(GL_QUADS, buffer->outlineCount, buffer->fillCount);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
     void TextRenderer::draw(char const *text, Sprite *target)
@@ -111,4 +75,123 @@ namespace crust {
         }
         return height;
     }
+
+    void TextRenderer::releaseUnusedBuffers()
+    {
+        TextBufferMap::iterator i = textBuffers_.begin();
+        while (i != textBuffers_.end()) {
+            if (i->second->used) {
+                i->second->used = false;
+                ++i;
+            } else {
+                i = textBuffers_.erase(i);
+            }
+        }
+    }
+
+    // Quads with a line width of two along the edges between set and unset
+    // pixels, and one quad for each set pixel.
+    void TextRenderer::initGlyphMesh(char key, GlyphMesh *mesh)
+    {
+        float halfLineWidth = 1.0f;
+        int width = font_->getGlyphWidth(key);
+        int height = font_->getGlyphHeight(key);
+        for (int dy = 0; dy < height + 1; ++dy) {
+            for (int dx = 0; dx < width + 1; ++dx) {
+                bool center = (dx < width && dy < height) && font_->getGlyphPixel(key, dx, dy);
+                bool left = (dx - 1 >= 0 && dy < height) && font_->getGlyphPixel(key, dx - 1, dy);
+                bool bottom = (dx < width && dy - 1 >= 0) && font_->getGlyphPixel(key, dx, dy - 1);
+                if (left != center) {
+                    GLfloat vertices[] = {
+                        float(dx) - halfLineWidth, float(dy) - halfLineWidth,
+                        float(dx) + halfLineWidth, float(dy) - halfLineWidth,
+                        float(dx) + halfLineWidth, float(dy + 1) + halfLineWidth,
+                        float(dx) - halfLineWidth, float(dy + 1) + halfLineWidth
+                    };
+                    mesh->outlineVertices.insert(mesh->outlineVertices.end(),
+                                                 vertices, vertices + 8);
+                }
+                if (bottom != center) {
+                    GLfloat vertices[] = {
+                        float(dx) - halfLineWidth, float(dy) - halfLineWidth,
+                        float(dx + 1) + halfLineWidth, float(dy) - halfLineWidth,
+                        float(dx + 1) + halfLineWidth, float(dy) + halfLineWidth,
+                        float(dx) - halfLineWidth, float(dy) + halfLineWidth
+                    };
+                    mesh->outlineVertices.insert(mesh->outlineVertices.end(),
+                                                 vertices, vertices + 8);
+                }
+                if (center) {
+                    GLfloat vertices[] = {
+                        float(dx), float(dy),
+                        float(dx + 1), float(dy),
+                        float(dx + 1), float(dy + 1),
+                        float(dx), float(dy + 1)
+                    };
+                    mesh->fillVertices.insert(mesh->fillVertices.end(),
+                                              vertices, vertices + 8);
+                }
+            }
+        }
+    }
+
+    // Lays out the outlines of all glyphs before the fills, so that the
+    // outline of a glyph never covers the fill of its neighbor.
+    TextRenderer::TextBuffer *TextRenderer::getTextBuffer(char const *text)
+    {
+        std::string key(text);
+        TextBufferMap::iterator i = textBuffers_.find(key);
+        if (i != textBuffers_.end()) {
+            i->second->used = true;
+            return i->second;
+        }
+
+        vertices_.clear();
+        std::size_t outlineSize = 0;
+        for (int pass = 0; pass < 2; ++pass) {
+            int x = 0;
+            for (char const *glyph = text; *glyph; ++glyph) {
+                if (glyph != text) {
+                    x += 1;
+                }
+                GlyphMesh const &mesh = glyphMeshes_[Font::Byte(*glyph)];
+                std::vector<GLfloat> const &vertices = pass ? mesh.fillVertices : mesh.outlineVertices;
+                for (std::size_t j = 0; j < vertices.size(); j += 2) {
+                    vertices_.push_back(vertices[j] + float(x));
+                    vertices_.push_back(vertices[j + 1]);
+                }
+                x += font_->getGlyphWidth(*glyph);
+            }
+            if (pass == 0) {
+                outlineSize = vertices_.size();
+            }
+        }
+
+        TextBuffer *buffer = new TextBuffer;
+        textBuffers_.insert(key, buffer);
+        buffer->outlineCount = GLsizei(outlineSize / 2);
+        buffer->fillCount = GLsizei((vertices_.size() - outlineSize) / 2);
+        buffer->used = true;
+        if (!vertices_.empty()) {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer->bufferHandle);
+            glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(GLfloat),
+                         &vertices_.front(), GL_STATIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        return buffer;
+    }
+
+    TextRenderer::TextBuffer::TextBuffer() :
+        bufferHandle(0),
+        outlineCount(0),
+        fillCount(0),
+        used(false)
+    {
+        glGenBuffers(1, &bufferHandle);
+    }
+
+    TextRenderer::TextBuffer::~TextBuffer()
+    {
+        glDeleteBuffers(1, &bufferHandle);
+    }
 }
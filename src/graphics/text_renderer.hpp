@@ -1,24 +1,64 @@
 #ifndef CRUST_TEXT_RENDERER_HPP
 #define CRUST_TEXT_RENDERER_HPP
 
+#include <string>
+#include <vector>
+#include <boost/ptr_container/ptr_unordered_map.hpp>
+#include <SDL/SDL_opengl.h>
+
 namespace crust {
     class Font;
     class Sprite;
     
+    // Draws text with a black outline. The outline and fill quads of each
+    // glyph are built once, and each string is laid out into a vertex
+    // buffer that is kept for as long as the string is drawn.
     class TextRenderer {
     public:
-        explicit TextRenderer(Font *font) :
-            font_(font)
-        { }
+        explicit TextRenderer(Font *font);
 
         void draw(char const *text);
         void draw(char const *text, Sprite *target);
 
         int getWidth(char const *text);
         int getHeight(char const *text);
+
+        // Frees the buffers of strings that have not been drawn since the
+        // previous call. Called once per frame.
+        void releaseUnusedBuffers();
         
     private:
+        class GlyphMesh {
+        public:
+            std::vector<GLfloat> outlineVertices;
+            std::vector<GLfloat> fillVertices;
+        };
+
+        class TextBuffer {
+        public:
+            GLuint bufferHandle;
+            GLsizei outlineCount;
+            GLsizei fillCount;
+            bool used;
+
+            TextBuffer();
+            ~TextBuffer();
+
+        private:
+            // Noncopyable.
+            TextBuffer(TextBuffer const &other);
+            TextBuffer &operator=(TextBuffer const &other);
+        };
+
+        typedef boost::ptr_unordered_map<std::string, TextBuffer> TextBufferMap;
+
         Font *font_;
+        std::vector<GlyphMesh> glyphMeshes_;
+        TextBufferMap textBuffers_;
+        std::vector<GLfloat> vertices_;
+
+        void initGlyphMesh(char key, GlyphMesh *mesh);
+        TextBuffer *getTextBuffer(char const *text);
     };
 }
 
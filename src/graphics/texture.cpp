@@ -25,6 +25,14 @@ namespace crust {
         pixels_.assign(pixelBytes, pixelBytes + size);
     }
     
+    void Texture::setSubPixels(GLint x, GLint y, GLsizei width, GLsizei height,
+                               GLvoid const *pixels)
+    {
+        bind();
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format_, type_, pixels);
+        unbind();
+    }
+
     void Texture::create()
     {
         if (handle_ == 0) {
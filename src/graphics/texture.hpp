@@ -68,6 +68,11 @@ namespace crust {
         
         void setPixels(GLvoid const *pixels, GLsizei size);
 
+        // Replaces a rectangle of an existing texture. The pixels use the
+        // format and type of the texture.
+        void setSubPixels(GLint x, GLint y, GLsizei width, GLsizei height,
+                          GLvoid const *pixels);
+
         GLint getMinFilter() const
         {
             return minFilter_;
@@ -2,11 +2,14 @@
 #define CRUST_GRID_HPP
 
 #include "int_geometry.hpp"
+#include "occupancy_counter.hpp"
 
 #include <algorithm>
 #include <cmath>
 
 namespace crust {
+    // Dense grid that grows to fit its elements. The bounds are always
+    // tight.
     template <typename T>
     class Grid {
     public:
@@ -14,8 +17,7 @@ namespace crust {
 
         explicit Grid(Element const &defaultValue = Element()) :
             defaultValue_(defaultValue),
-            elements_(0),
-            normalized_(true)
+            elements_(0)
         { }
         
         ~Grid()
@@ -25,27 +27,27 @@ namespace crust {
 
         int getX() const
         {
-            return innerBox_.p1.x;
+            return counter_.getBounds().p1.x;
         }
 
         int getY() const
         {
-            return innerBox_.p1.y;
+            return counter_.getBounds().p1.y;
         }
 
         int getWidth() const
         {
-            return innerBox_.getWidth();
+            return counter_.getBounds().getWidth();
         }
 
         int getHeight() const
         {
-            return innerBox_.getHeight();
+            return counter_.getBounds().getHeight();
         }
 
         bool isEmpty() const
         {
-            return innerBox_.isEmpty();
+            return counter_.getCount() == 0;
         }
         
         int getPitch() const
@@ -53,14 +55,9 @@ namespace crust {
             return outerBox_.getWidth();
         }
 
-        bool isNormalized() const
-        {
-            return normalized_;
-        }
-
         Element const &getElement(int x, int y) const
         {
-            if (innerBox_.containsPoint(IntVector2(x, y))) {
+            if (outerBox_.containsPoint(IntVector2(x, y))) {
                 return elements_[getIndex(x, y)];
             } else {
                 return defaultValue_;
@@ -78,36 +75,17 @@ namespace crust {
 
         void swap(Grid &other)
         {
-            std::swap(innerBox_, other.innerBox_);
             std::swap(outerBox_, other.outerBox_);
             std::swap(defaultValue_, other.defaultValue_);
             std::swap(elements_, other.elements_);
-            std::swap(normalized_, other.normalized_);
-        }
-        
-        void normalize()
-        {
-            if (!normalized_) {
-                IntBox2 box;
-                for (int y = innerBox_.p1.y; y < innerBox_.p2.y; ++y) {
-                    for (int x = innerBox_.p1.x; x < innerBox_.p2.x; ++x) {
-                        if (elements_[getIndex(x, y)] != defaultValue_) {
-                            box.mergePoint(IntVector2(x, y));
-                        }
-                    }
-                }
-                innerBox_ = box;
-                normalized_ = true;
-            }
+            counter_.swap(other.counter_);
         }
 
     private:
         explicit Grid(IntBox2 const &box, Element const &defaultValue) :
-            innerBox_(box),
             outerBox_(box),
             defaultValue_(defaultValue),
-            elements_(0),
-            normalized_(true)
+            elements_(0)
         {
             int dx = std::max(1, int(0.5f * M_SQRT2 * float(box.getWidth()) + 0.5f));
             int dy = std::max(1, int(0.5f * M_SQRT2 * float(box.getHeight()) + 0.5f));
@@ -122,38 +100,37 @@ namespace crust {
         Grid(Grid const &other);
         Grid &operator=(Grid const &other);
 
-        IntBox2 innerBox_;
         IntBox2 outerBox_;
         Element defaultValue_;
         Element *elements_;
-        bool normalized_;
+        OccupancyCounter counter_;
 
         void addElement(int x, int y, Element const &value)
         {
-            if (innerBox_.containsPoint(IntVector2(x, y))) {
-                elements_[getIndex(x, y)] = value;
-            } else if (outerBox_.containsPoint(IntVector2(x, y))) {
-                innerBox_.mergePoint(IntVector2(x, y));
-                elements_[getIndex(x, y)] = value;
-            } else {
-                normalize();
-                
-                IntBox2 box(innerBox_);
+            if (!outerBox_.containsPoint(IntVector2(x, y))) {
+                IntBox2 box(counter_.getBounds());
                 box.mergePoint(IntVector2(x, y));
                 
                 Grid other(box, defaultValue_);
                 copyElements(other);
-                swap(other);
-                
-                elements_[getIndex(x, y)] = value;
+                std::swap(outerBox_, other.outerBox_);
+                std::swap(elements_, other.elements_);
+            }
+            Element &element = elements_[getIndex(x, y)];
+            if (element == defaultValue_) {
+                counter_.addCell(x, y);
             }
+            element = value;
         }
 
         void removeElement(int x, int y)
         {
-            if (innerBox_.containsPoint(IntVector2(x, y))) {
-                elements_[getIndex(x, y)] = defaultValue_;
-                normalized_ = false;
+            if (outerBox_.containsPoint(IntVector2(x, y))) {
+                Element &element = elements_[getIndex(x, y)];
+                if (element != defaultValue_) {
+                    element = defaultValue_;
+                    counter_.removeCell(x, y);
+                }
             }
         }
 
@@ -165,8 +142,9 @@ namespace crust {
 
         void copyElements(Grid &target) const
         {
-            for (int y = innerBox_.p1.y; y < innerBox_.p2.y; ++y) {
-                for (int x = innerBox_.p1.x; x < innerBox_.p2.x; ++x) {
+            IntBox2 const &box = counter_.getBounds();
+            for (int y = box.p1.y; y < box.p2.y; ++y) {
+                for (int x = box.p1.x; x < box.p2.x; ++x) {
                     target.elements_[target.getIndex(x, y)] = elements_[getIndex(x, y)];
                 }
             }
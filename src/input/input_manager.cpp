@@ -5,6 +5,7 @@
 #include "convert.hpp"
 #include "game.hpp"
 #include "graphics_manager.hpp"
+#include "input_recording.hpp"
 #include "monster_control_component.hpp"
 #include "task.hpp"
 
@@ -28,11 +29,19 @@ namespace crust {
     
     void InputManager::step(float dt)
     {
+        ProfileZone zone(game_->getProfiler(), "INPUT");
         for (TaskVector::iterator i = tasks_.begin(); i != tasks_.end(); ++i) {
             (*i)->step(dt);
         }
-        handleEvents();
-        handleInput();
+        if (game_->getInputPlayer()) {
+            replayInput(game_->getInputPlayer());
+        } else if (!game_->getConfig()->headless) {
+            handleEvents();
+            handleInput();
+        }
+        if (game_->getInputRecorder()) {
+            recordInput(game_->getInputRecorder());
+        }
     }
 
     void InputManager::handleEvents()
@@ -101,6 +110,17 @@ namespace crust {
                 }
                 break;
                 
+            case SDLK_F3:
+            {
+                GraphicsManager *graphicsManager = game_->getGraphicsManager();
+                graphicsManager->setProfileDrawEnabled(!graphicsManager->isProfileDrawEnabled());
+            }
+                break;
+
+            case SDLK_F12:
+                game_->writeTrace();
+                break;
+
             case SDLK_PLUS:
             {
                 float scale = game_->getGraphicsManager()->getCameraScale();
@@ -171,4 +191,41 @@ namespace crust {
             controlComponent->setTargetPosition(targetPosition);
         }
     }
+
+    // The game stops replays before the recording runs out. Quit anyway if
+    // stepped past the end.
+    void InputManager::replayInput(InputPlayer *player)
+    {
+        InputFrame frame;
+        if (!player->readFrame(&frame)) {
+            game_->setQuitting(true);
+            return;
+        }
+        if (game_->getPlayerActor()) {
+            MonsterControlComponent *controlComponent = convert(game_->getPlayerActor()->getControlComponent());
+            controlComponent->setLeftControl(frame.leftControl);
+            controlComponent->setRightControl(frame.rightControl);
+            controlComponent->setJumpControl(frame.jumpControl);
+            controlComponent->setActionControl(frame.actionControl);
+            controlComponent->setTargetPosition(frame.targetPosition);
+            controlComponent->setActionMode(MonsterControlComponent::ActionMode(frame.actionMode));
+        }
+    }
+
+    // Writes a frame for every step, also before the player has spawned,
+    // so that frames and steps line up on replay.
+    void InputManager::recordInput(InputRecorder *recorder)
+    {
+        InputFrame frame;
+        if (game_->getPlayerActor()) {
+            MonsterControlComponent *controlComponent = convert(game_->getPlayerActor()->getControlComponent());
+            frame.leftControl = controlComponent->getLeftControl();
+            frame.rightControl = controlComponent->getRightControl();
+            frame.jumpControl = controlComponent->getJumpControl();
+            frame.actionControl = controlComponent->getActionControl();
+            frame.targetPosition = controlComponent->getTargetPosition();
+            frame.actionMode = controlComponent->getActionMode();
+        }
+        recorder->writeFrame(frame);
+    }
 }
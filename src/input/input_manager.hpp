@@ -6,6 +6,8 @@
 
 namespace crust {
     class Game;
+    class InputPlayer;
+    class InputRecorder;
     class Task;
     
     class InputManager {
@@ -30,6 +32,8 @@ namespace crust {
         void handleMouseButtonDownEvent(SDL_Event *event);
         void handleMouseButtonUpEvent(SDL_Event *event);
         void handleInput();
+        void replayInput(InputPlayer *player);
+        void recordInput(InputRecorder *recorder);
     };
 }
 
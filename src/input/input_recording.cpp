@@ -0,0 +1,177 @@
+#include "input_recording.hpp"
+
+#include "error.hpp"
+
+#include <cstring>
+#include <iterator>
+#include <sstream>
+
+namespace crust {
+    namespace {
+        enum {
+            LEFT_BIT = 1 << 0,
+            RIGHT_BIT = 1 << 1,
+            JUMP_BIT = 1 << 2,
+            ACTION_BIT = 1 << 3,
+            ACTION_MODE_SHIFT = 4
+        };
+
+        char const *getMagic()
+        {
+            return "CRIR";
+        }
+
+        void putUint32(boost::uint32_t value, std::vector<char> *bytes)
+        {
+            for (int i = 0; i < 4; ++i) {
+                bytes->push_back(char(value >> (8 * i)));
+            }
+        }
+
+        void putUint64(boost::uint64_t value, std::vector<char> *bytes)
+        {
+            putUint32(boost::uint32_t(value), bytes);
+            putUint32(boost::uint32_t(value >> 32), bytes);
+        }
+
+        void putFloat(float value, std::vector<char> *bytes)
+        {
+            boost::uint32_t bits;
+            std::memcpy(&bits, &value, 4);
+            putUint32(bits, bytes);
+        }
+
+        boost::uint32_t getUint32(unsigned char const *bytes)
+        {
+            return (boost::uint32_t(bytes[0]) | boost::uint32_t(bytes[1]) << 8 |
+                    boost::uint32_t(bytes[2]) << 16 | boost::uint32_t(bytes[3]) << 24);
+        }
+
+        boost::uint64_t getUint64(unsigned char const *bytes)
+        {
+            return boost::uint64_t(getUint32(bytes)) | boost::uint64_t(getUint32(bytes + 4)) << 32;
+        }
+
+        float getFloat(unsigned char const *bytes)
+        {
+            boost::uint32_t bits = getUint32(bytes);
+            float value;
+            std::memcpy(&value, &bits, 4);
+            return value;
+        }
+    }
+
+    InputFrame::InputFrame() :
+        leftControl(false),
+        rightControl(false),
+        jumpControl(false),
+        actionControl(false),
+        actionMode(0)
+    { }
+
+    InputRecorder::InputRecorder(char const *path, Random::Seed seed, int fps) :
+        path_(path),
+        file_(path, std::ios::binary),
+        frameCount_(0)
+    {
+        if (!file_.is_open()) {
+            std::stringstream message;
+            message << "Failed to open input recording for writing: " << path_;
+            throw Error(message.str());
+        }
+        std::vector<char> bytes(getMagic(), getMagic() + 4);
+        putUint32(INPUT_RECORDING_VERSION, &bytes);
+        putUint64(seed, &bytes);
+        putUint32(boost::uint32_t(fps), &bytes);
+        putUint32(0, &bytes);
+        write(bytes);
+    }
+
+    void InputRecorder::writeFrame(InputFrame const &frame)
+    {
+        int flags = ((frame.leftControl ? LEFT_BIT : 0) |
+                     (frame.rightControl ? RIGHT_BIT : 0) |
+                     (frame.jumpControl ? JUMP_BIT : 0) |
+                     (frame.actionControl ? ACTION_BIT : 0) |
+                     frame.actionMode << ACTION_MODE_SHIFT);
+        std::vector<char> bytes(1, char(flags));
+        putFloat(frame.targetPosition.x, &bytes);
+        putFloat(frame.targetPosition.y, &bytes);
+        write(bytes);
+        ++frameCount_;
+    }
+
+    void InputRecorder::write(std::vector<char> const &bytes)
+    {
+        file_.write(&bytes.front(), std::streamsize(bytes.size()));
+        if (!file_) {
+            std::stringstream message;
+            message << "Failed to write input recording: " << path_;
+            throw Error(message.str());
+        }
+    }
+
+    InputPlayer::InputPlayer(char const *path) :
+        path_(path),
+        seed_(0),
+        fps_(0),
+        frameCount_(0),
+        frameIndex_(0)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            std::stringstream message;
+            message << "Failed to open input recording: " << path_;
+            throw Error(message.str());
+        }
+        data_.assign(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+
+        unsigned char const *bytes = reinterpret_cast<unsigned char const *>(data_.empty() ? 0 : &data_.front());
+        if (data_.size() < INPUT_RECORDING_HEADER_SIZE ||
+            std::memcmp(bytes, getMagic(), 4) != 0)
+        {
+            std::stringstream message;
+            message << "Not an input recording: " << path_;
+            throw Error(message.str());
+        }
+        boost::uint32_t version = getUint32(bytes + 4);
+        if (version != INPUT_RECORDING_VERSION) {
+            std::stringstream message;
+            message << "Unsupported input recording version " << version
+                    << ": " << path_;
+            throw Error(message.str());
+        }
+        seed_ = getUint64(bytes + 8);
+        fps_ = int(getUint32(bytes + 16));
+        if (fps_ <= 0) {
+            std::stringstream message;
+            message << "Invalid step rate in input recording: " << path_;
+            throw Error(message.str());
+        }
+
+        // A recording that was cut short loses its last partial frame.
+        std::size_t frameBytes = data_.size() - INPUT_RECORDING_HEADER_SIZE;
+        frameCount_ = int(frameBytes / INPUT_FRAME_SIZE);
+    }
+
+    bool InputPlayer::readFrame(InputFrame *frame)
+    {
+        if (frameIndex_ >= frameCount_) {
+            return false;
+        }
+        unsigned char const *bytes = (reinterpret_cast<unsigned char const *>(&data_.front()) +
+                                      INPUT_RECORDING_HEADER_SIZE +
+                                      frameIndex_ * INPUT_FRAME_SIZE);
+        int flags = bytes[0];
+        frame->leftControl = bool(flags & LEFT_BIT);
+        frame->rightControl = bool(flags & RIGHT_BIT);
+        frame->jumpControl = bool(flags & JUMP_BIT);
+        frame->actionControl = bool(flags & ACTION_BIT);
+        frame->actionMode = flags >> ACTION_MODE_SHIFT;
+        frame->targetPosition.x = getFloat(bytes + 1);
+        frame->targetPosition.y = getFloat(bytes + 5);
+        ++frameIndex_;
+        return true;
+    }
+}
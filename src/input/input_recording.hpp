@@ -0,0 +1,107 @@
+#ifndef CRUST_INPUT_RECORDING_HPP
+#define CRUST_INPUT_RECORDING_HPP
+
+#include "geometry.hpp"
+#include "random.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace crust {
+    // Controls of the player for one fixed step.
+    class InputFrame {
+    public:
+        bool leftControl;
+        bool rightControl;
+        bool jumpControl;
+        bool actionControl;
+        int actionMode;
+        Vector2 targetPosition;
+
+        InputFrame();
+    };
+
+    // An input recording starts with a header holding the world seed and
+    // the step rate, followed by one frame per fixed step. A frame packs
+    // the controls and the action mode into a byte, followed by the
+    // target position. Everything is stored little-endian.
+    enum {
+        INPUT_RECORDING_VERSION = 1,
+        INPUT_RECORDING_HEADER_SIZE = 24,
+        INPUT_FRAME_SIZE = 9
+    };
+
+    // Writes the inputs of a session as it runs, so that the same session
+    // can be replayed step for step.
+    class InputRecorder {
+    public:
+        InputRecorder(char const *path, Random::Seed seed, int fps);
+
+        int getFrameCount() const
+        {
+            return frameCount_;
+        }
+
+        void writeFrame(InputFrame const &frame);
+
+    private:
+        std::string path_;
+        std::ofstream file_;
+        int frameCount_;
+
+        // Noncopyable.
+        InputRecorder(InputRecorder const &other);
+        InputRecorder &operator=(InputRecorder const &other);
+
+        void write(std::vector<char> const &bytes);
+    };
+
+    // Reads back an input recording, one frame per fixed step.
+    class InputPlayer {
+    public:
+        explicit InputPlayer(char const *path);
+
+        Random::Seed getSeed() const
+        {
+            return seed_;
+        }
+
+        int getFps() const
+        {
+            return fps_;
+        }
+
+        int getFrameCount() const
+        {
+            return frameCount_;
+        }
+
+        int getFrameIndex() const
+        {
+            return frameIndex_;
+        }
+
+        bool isFinished() const
+        {
+            return frameIndex_ == frameCount_;
+        }
+
+        // Returns false when there are no frames left.
+        bool readFrame(InputFrame *frame);
+
+    private:
+        std::string path_;
+        std::vector<char> data_;
+        Random::Seed seed_;
+        int fps_;
+        int frameCount_;
+        int frameIndex_;
+
+        // Noncopyable.
+        InputPlayer(InputPlayer const &other);
+        InputPlayer &operator=(InputPlayer const &other);
+    };
+}
+
+#endif
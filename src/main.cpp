@@ -1,23 +1,124 @@
+#include "asset_pack.hpp"
 #include "config.hpp"
 #include "config_reader.hpp"
 #include "error.hpp"
 #include "game.hpp"
 
 #include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+    // Settings from the command line, which override the config files.
+    class Arguments {
+    public:
+        std::string packPath;
+        std::string configPath;
+        std::string recordPath;
+        std::string replayPath;
+    };
+
+    // Accepts --pack, --config, --record and --replay, each followed by a
+    // path. A bare path is taken as the asset pack.
+    void parseArguments(int argc, char **argv, Arguments *arguments)
+    {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.empty() || arg[0] != '-') {
+                arguments->packPath = arg;
+                continue;
+            }
+            std::string *path = 0;
+            if (arg == "--pack") {
+                path = &arguments->packPath;
+            } else if (arg == "--config") {
+                path = &arguments->configPath;
+            } else if (arg == "--record") {
+                path = &arguments->recordPath;
+            } else if (arg == "--replay") {
+                path = &arguments->replayPath;
+            } else {
+                std::stringstream message;
+                message << "Unknown option " << arg << std::endl
+                        << "Usage: crust [--pack <file>] [--config <file>] "
+                        << "[--record <file>] [--replay <file>]";
+                throw crust::Error(message.str());
+            }
+            if (i + 1 == argc) {
+                std::stringstream message;
+                message << "Missing path after " << arg;
+                throw crust::Error(message.str());
+            }
+            *path = argv[++i];
+        }
+    }
+
+    // Without a path on the command line, the asset pack is found next to
+    // the executable, so that the working directory does not matter.
+    std::string getDefaultAssetPackPath(int argc, char **argv)
+    {
+        std::string path(argc >= 1 ? argv[0] : "");
+        std::string::size_type separator = path.find_last_of("/\\");
+        if (separator == std::string::npos) {
+            return "crust.pack";
+        }
+        return path.substr(0, separator + 1) + "crust.pack";
+    }
+}
 
 int main(int argc, char **argv)
 {
-    std::ifstream configFile("../../../data/config.txt");
+    Arguments arguments;
+    parseArguments(argc, argv, &arguments);
+    if (arguments.packPath.empty()) {
+        arguments.packPath = getDefaultAssetPackPath(argc, argv);
+    }
+
+    crust::AssetPack assetPack;
+    assetPack.open(arguments.packPath.c_str());
+
     crust::Config config;
-    crust::ConfigReader configReader(&configFile, &config);
-    configReader.read();
+    if (assetPack.hasAsset("config.txt")) {
+        crust::Asset asset = assetPack.getAsset("config.txt");
+        std::istringstream configStream(std::string(asset.data, asset.size));
+        crust::ConfigReader configReader(&configStream, &config);
+        configReader.read();
+    }
+
+    // An explicit config file overrides the baked one, so that settings
+    // can change without rebuilding the pack.
+    if (!arguments.configPath.empty()) {
+        std::ifstream configFile(arguments.configPath.c_str());
+        if (!configFile.is_open()) {
+            std::stringstream message;
+            message << "Failed to open config file: " << arguments.configPath;
+            throw crust::Error(message.str());
+        }
+        crust::ConfigReader configReader(&configFile, &config);
+        configReader.read();
+    }
+    if (!arguments.recordPath.empty()) {
+        config.recordPath = arguments.recordPath;
+    }
+    if (!arguments.replayPath.empty()) {
+        config.replayPath = arguments.replayPath;
+    }
+#ifdef CRUST_HEADLESS
+    config.headless = true;
+#endif
+
+    // Replays run without a window, as fast as the simulation allows.
+    if (!config.replayPath.empty()) {
+        config.headless = true;
+    }
 
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_NOPARACHUTE) != 0) {
+    Uint32 flags = config.headless ? SDL_INIT_TIMER : SDL_INIT_VIDEO;
+    if (SDL_Init(flags | SDL_INIT_NOPARACHUTE) != 0) {
         std::stringstream message;
         message << "Failed to initialize SDL: " << SDL_GetError();
         throw crust::Error(message.str());
     }
 
-    crust::Game(&config).run();
+    crust::Game(&config, &assetPack).run();
     return 0;
 }
@@ -18,6 +18,11 @@ namespace crust {
             p2(std::numeric_limits<int>::min(),
                std::numeric_limits<int>::min())
         { }
+
+        IntBox2(IntVector2 const &p1, IntVector2 const &p2) :
+            p1(p1),
+            p2(p2)
+        { }
         
         int getWidth() const
         {
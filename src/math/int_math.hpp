@@ -50,6 +50,16 @@ namespace crust {
         }
     };
     
+    inline bool operator==(IntVector2 const &v1, IntVector2 const &v2)
+    {
+        return v1.x == v2.x && v1.y == v2.y;
+    }
+
+    inline bool operator!=(IntVector2 const &v1, IntVector2 const &v2)
+    {
+        return !(v1 == v2);
+    }
+
     inline IntVector2 operator+(IntVector2 const &v1, IntVector2 const &v2)
     {
         return IntVector2(v1) += v2;
@@ -165,6 +165,11 @@ namespace crust {
         return result;
     }
 
+    inline Vector2 mix(Vector2 const &v1, Vector2 const &v2, float x)
+    {
+        return v1 * (1.0f - x) + v2 * x;
+    }
+
     inline float getDistance(Vector2 const &p1, Vector2 const &p2)
     {
         return (p2 - p1).getLength();
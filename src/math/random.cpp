@@ -1,24 +1,92 @@
 #include "random.hpp"
 
-#include <algorithm>
-#include <cstdlib>
 #include <ctime>
-#include <limits>
 
 namespace crust {
+    namespace {
+        boost::uint64_t rotateLeft(boost::uint64_t x, int k)
+        {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        // http://prng.di.unimi.it/splitmix64.c
+        boost::uint64_t splitMix(boost::uint64_t *state)
+        {
+            boost::uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+    }
+
     Random::Random()
     {
-        std::srand(std::time(0));
+        *this = Random(Seed(std::time(0)));
+    }
+
+    // Splitmix never yields an all-zero state, which xoshiro would be
+    // stuck in.
+    Random::Random(Seed seed)
+    {
+        boost::uint64_t splitMixState = seed;
+        for (int i = 0; i < 4; ++i) {
+            state_[i] = splitMix(&splitMixState);
+        }
+    }
+
+    Random Random::getStream(int index) const
+    {
+        Random result(*this);
+        for (int i = 0; i <= index; ++i) {
+            result.jump();
+        }
+        return result;
     }
 
     float Random::getFloat()
     {
-        return std::min(float(std::rand()) / float(RAND_MAX),
-                        1.0f - std::numeric_limits<float>::epsilon());
+        return float(next() >> 40) * (1.0f / 16777216.0f);
     }
 
     int Random::getInt(int size)
     {
-        return std::rand() % size;
+        return int(((next() >> 32) * boost::uint64_t(size)) >> 32);
+    }
+
+    boost::uint64_t Random::next()
+    {
+        boost::uint64_t result = rotateLeft(state_[1] * 5, 7) * 9;
+        boost::uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotateLeft(state_[3], 45);
+        return result;
+    }
+
+    // Equivalent to 2^128 calls to next.
+    void Random::jump()
+    {
+        static boost::uint64_t const jumpPolynomial[] = {
+            0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+            0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+        };
+
+        boost::uint64_t state[4] = { 0, 0, 0, 0 };
+        for (int i = 0; i < 4; ++i) {
+            for (int b = 0; b < 64; ++b) {
+                if (jumpPolynomial[i] & (boost::uint64_t(1) << b)) {
+                    for (int j = 0; j < 4; ++j) {
+                        state[j] ^= state_[j];
+                    }
+                }
+                next();
+            }
+        }
+        for (int j = 0; j < 4; ++j) {
+            state_[j] = state[j];
+        }
     }
 }
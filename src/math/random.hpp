@@ -1,14 +1,36 @@
 #ifndef CRUST_RANDOM_HPP
 #define CRUST_RANDOM_HPP
 
+#include <boost/cstdint.hpp>
+
 namespace crust {
-    // TODO: Use Boost.Random as back-end.
+    // Pseudo-random number generator with its state in the instance, so
+    // that each thread or subsystem can have its own. Uses xoshiro256**.
+    //
+    // http://prng.di.unimi.it/
     class Random {
     public:
+        typedef boost::uint64_t Seed;
+
+        // Seeds the generator from the current time.
         Random();
 
+        // Same seed, same sequence.
+        explicit Random(Seed seed);
+
+        // Returns a generator for an independent stream. Streams with
+        // different indices never overlap, and the same index always
+        // gives the same stream.
+        Random getStream(int index) const;
+
         float getFloat();
         int getInt(int size);
+
+    private:
+        boost::uint64_t state_[4];
+
+        boost::uint64_t next();
+        void jump();
     };
 }
 
@@ -0,0 +1,92 @@
+#include "occupancy_counter.hpp"
+
+#include <algorithm>
+
+namespace crust {
+    OccupancyCounter::OccupancyCounter() :
+        count_(0)
+    { }
+
+    void OccupancyCounter::addCell(int x, int y)
+    {
+        rows_.increment(y);
+        columns_.increment(x);
+        bounds_.mergePoint(IntVector2(x, y));
+        ++count_;
+    }
+
+    // Shrinking walks over the empty rows and columns between the old and
+    // the new edge, so clearing an edge cell costs as much as the gap to
+    // the next occupied row or column. Clearing an interior cell is O(1).
+    void OccupancyCounter::removeCell(int x, int y)
+    {
+        rows_.decrement(y);
+        columns_.decrement(x);
+        if (--count_ == 0) {
+            bounds_ = IntBox2();
+            return;
+        }
+        while (rows_.getCount(bounds_.p1.y) == 0) {
+            ++bounds_.p1.y;
+        }
+        while (rows_.getCount(bounds_.p2.y - 1) == 0) {
+            --bounds_.p2.y;
+        }
+        while (columns_.getCount(bounds_.p1.x) == 0) {
+            ++bounds_.p1.x;
+        }
+        while (columns_.getCount(bounds_.p2.x - 1) == 0) {
+            --bounds_.p2.x;
+        }
+    }
+
+    void OccupancyCounter::clear()
+    {
+        bounds_ = IntBox2();
+        count_ = 0;
+        rows_.clear();
+        columns_.clear();
+    }
+
+    void OccupancyCounter::swap(OccupancyCounter &other)
+    {
+        std::swap(bounds_, other.bounds_);
+        std::swap(count_, other.count_);
+        rows_.swap(other.rows_);
+        columns_.swap(other.columns_);
+    }
+
+    OccupancyCounter::Counts::Counts() :
+        offset_(0)
+    { }
+
+    // Grows by half the size on the side that needs to grow.
+    void OccupancyCounter::Counts::increment(int i)
+    {
+        int size = int(counts_.size());
+        if (counts_.empty()) {
+            offset_ = i;
+            counts_.resize(1, 0);
+        } else if (i < offset_) {
+            int slack = (offset_ + size - i) / 2;
+            counts_.insert(counts_.begin(), offset_ - i + slack, 0);
+            offset_ = i - slack;
+        } else if (offset_ + size <= i) {
+            int slack = (i + 1 - offset_) / 2;
+            counts_.resize(i + 1 - offset_ + slack, 0);
+        }
+        ++counts_[i - offset_];
+    }
+
+    void OccupancyCounter::Counts::clear()
+    {
+        offset_ = 0;
+        counts_.clear();
+    }
+
+    void OccupancyCounter::Counts::swap(Counts &other)
+    {
+        std::swap(offset_, other.offset_);
+        counts_.swap(other.counts_);
+    }
+}
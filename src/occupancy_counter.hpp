@@ -0,0 +1,74 @@
+#ifndef CRUST_OCCUPANCY_COUNTER_HPP
+#define CRUST_OCCUPANCY_COUNTER_HPP
+
+#include "int_geometry.hpp"
+
+#include <vector>
+
+namespace crust {
+    // Counts the occupied cells of a grid per row and per column. The
+    // bounds stay tight as cells are cleared, without scanning the grid.
+    class OccupancyCounter {
+    public:
+        OccupancyCounter();
+
+        IntBox2 const &getBounds() const
+        {
+            return bounds_;
+        }
+
+        int getCount() const
+        {
+            return count_;
+        }
+
+        int getRowCount(int y) const
+        {
+            return rows_.getCount(y);
+        }
+
+        int getColumnCount(int x) const
+        {
+            return columns_.getCount(x);
+        }
+
+        void addCell(int x, int y);
+        void removeCell(int x, int y);
+
+        void clear();
+        void swap(OccupancyCounter &other);
+
+    private:
+        class Counts {
+        public:
+            Counts();
+
+            int getCount(int i) const
+            {
+                int j = i - offset_;
+                return (0 <= j && j < int(counts_.size())) ? counts_[j] : 0;
+            }
+
+            void increment(int i);
+
+            void decrement(int i)
+            {
+                --counts_[i - offset_];
+            }
+
+            void clear();
+            void swap(Counts &other);
+
+        private:
+            int offset_;
+            std::vector<int> counts_;
+        };
+
+        IntBox2 bounds_;
+        int count_;
+        Counts rows_;
+        Counts columns_;
+    };
+}
+
+#endif
@@ -6,62 +6,121 @@
 
 namespace crust {
     BlockPhysicsComponent::BlockPhysicsComponent(Actor *actor, Polygon2 const &polygon) :
+        Component(componentType),
         actor_(actor),
         physicsManager_(actor->getGame()->getPhysicsManager()),
         polygon_(polygon),
+        stateValid_(false),
         body_(0),
-        mineDuration_(0.0f)
+        radius_(0.0f),
+        mineDuration_(0.0f),
+        blockIndex_(-1),
+        activeBlockIndex_(-1),
+        modified_(false),
+        generatedIndex_(-1)
+    { }
+
+    BlockPhysicsComponent::BlockPhysicsComponent(Actor *actor, BlockState const &state) :
+        Component(componentType),
+        actor_(actor),
+        physicsManager_(actor->getGame()->getPhysicsManager()),
+        state_(state),
+        stateValid_(true),
+        body_(0),
+        radius_(0.0f),
+        mineDuration_(0.0f),
+        blockIndex_(-1),
+        activeBlockIndex_(-1),
+        modified_(state.modified),
+        generatedIndex_(state.generatedIndex)
     { }
 
     BlockPhysicsComponent::~BlockPhysicsComponent()
     { }
 
+    void BlockPhysicsComponent::initState(Polygon2 const &polygon,
+                                          float angle, BlockState *state)
+    {
+        Vector2 centroid = polygon.getCentroid();
+        b2Transform transform(b2Vec2(centroid.x, centroid.y), b2Rot(angle));
+        Polygon2 localPolygon;
+        for (int i = 0; i < polygon.getSize(); ++i) {
+            b2Vec2 vertex(polygon.vertices[i].x, polygon.vertices[i].y);
+            b2Vec2 localVertex = b2MulT(transform, vertex);
+            localPolygon.vertices.push_back(Vector2(localVertex.x, localVertex.y));
+        }
+
+        state->position = centroid;
+        state->angle = angle;
+        state->dynamic = false;
+        state->modified = false;
+        int vertexCount = std::min(localPolygon.getSize(),
+                                   int(b2_maxPolygonVertices));
+        state->localPolygon.vertices.assign(localPolygon.vertices.begin(),
+                                            localPolygon.vertices.begin() + vertexCount);
+
+        BitGrid grid;
+        rasterize(localPolygon, &grid);
+        copyGrid(grid, state);
+        state->gridColors.clear();
+    }
+
     void BlockPhysicsComponent::create()
     {
-        Vector2 centroid = polygon_.getCentroid();
-        float angle = -M_PI + 2.0f * M_PI * actor_->getGame()->getRandomFloat();
-        
+        if (!stateValid_) {
+            float angle = -M_PI + 2.0f * M_PI * actor_->getGame()->getRandomFloat();
+            initState(polygon_, angle, &state_);
+            stateValid_ = true;
+        }
+
         b2BodyDef bodyDef;
-        bodyDef.position.Set(centroid.x, centroid.y);
-        bodyDef.angle = angle;
+        bodyDef.position.Set(state_.position.x, state_.position.y);
+        bodyDef.angle = state_.angle;
         bodyDef.userData = actor_;
         body_ = physicsManager_->getWorld()->CreateBody(&bodyDef);
-        
-        b2Vec2 vertices[b2_maxPolygonVertices];
-        int32 vertexCount = std::min(int32(polygon_.vertices.size()),
-                                     b2_maxPolygonVertices);
-        
-        for (int32 i = 0; i < vertexCount; ++i) {
-            b2Vec2 vertex(polygon_.vertices[i].x, polygon_.vertices[i].y);
-            vertices[i] = body_->GetLocalPoint(vertex);
-            localPolygon_.vertices.push_back(Vector2(vertices[i].x, vertices[i].y));
+
+        localPolygon_ = state_.localPolygon;
+        createFixtures();
+
+        IntBox2 const &box = state_.gridBox;
+        int i = 0;
+        for (int y = box.p1.y; y < box.p2.y; ++y) {
+            for (int x = box.p1.x; x < box.p2.x; ++x) {
+                if (state_.gridElements[i++]) {
+                    grid_.setElement(x, y, true);
+                }
+            }
         }
-        b2PolygonShape shape;
-        shape.Set(vertices, vertexCount);
-        b2FixtureDef fixtureDef;
-        fixtureDef.shape = &shape;
-        fixtureDef.density = 2.5f;
-        fixtureDef.filter.groupIndex = -1;
-        body_->CreateFixture(&fixtureDef);
-        
-        Polygon2 innerPolygon = polygon_;
-        innerPolygon.pad(-0.15f);
-        for (int32 i = 0; i < vertexCount; ++i) {
-            b2Vec2 vertex(innerPolygon.vertices[i].x, innerPolygon.vertices[i].y);
-            vertices[i] = body_->GetLocalPoint(vertex);
+
+        physicsManager_->addBlockComponent(this);
+        if (state_.dynamic) {
+            makeDynamic();
         }
-        b2PolygonShape innerShape;
-        innerShape.Set(vertices, vertexCount);
-        body_->CreateFixture(&innerShape, 0.0f);
-        
-        rasterize(polygon_);
+
+        // Only needed until the body and grid have been created.
+        state_ = BlockState();
     }
 
     void BlockPhysicsComponent::destroy()
     {
+        physicsManager_->removeActiveBlockComponent(this);
+        physicsManager_->removeBlockComponent(this);
         physicsManager_->getWorld()->DestroyBody(body_);
     }
 
+    void BlockPhysicsComponent::makeDynamic()
+    {
+        modified_ = true;
+        body_->SetType(b2_dynamicBody);
+        physicsManager_->addActiveBlockComponent(this);
+    }
+
+    void BlockPhysicsComponent::makeStatic()
+    {
+        body_->SetType(b2_staticBody);
+        physicsManager_->removeActiveBlockComponent(this);
+    }
+
     int BlockPhysicsComponent::getElement(int x, int y)
     {
         return grid_.getElement(x, y);
@@ -69,7 +128,8 @@ namespace crust {
     
     void BlockPhysicsComponent::setElement(int x, int y, int type)
     {
-        grid_.setElement(x, y, type);
+        modified_ = true;
+        grid_.setElement(x, y, type != 0);
     }
     
     bool BlockPhysicsComponent::findElementNearPosition(float x, float y)
@@ -77,11 +137,7 @@ namespace crust {
         b2Vec2 localPosition = body_->GetLocalPoint(b2Vec2(x, y));
         int xIndex = int(std::floor(10.0f * localPosition.x + 0.5f));
         int yIndex = int(std::floor(10.0f * localPosition.y + 0.5f));
-        return (getElement(xIndex, yIndex) ||
-                getElement(xIndex - 1, yIndex) ||
-                getElement(xIndex + 1, yIndex) ||
-                getElement(xIndex, yIndex - 1) ||
-                getElement(xIndex, yIndex + 1));
+        return grid_.isCrossSet(xIndex, yIndex);
     }
     
     int BlockPhysicsComponent::getElementAtPosition(float x, float y)
@@ -100,6 +156,19 @@ namespace crust {
         setElement(xIndex, yIndex, type);
     }
     
+    void BlockPhysicsComponent::getState(BlockState *state) const
+    {
+        b2Vec2 position = body_->GetPosition();
+        state->position = Vector2(position.x, position.y);
+        state->angle = body_->GetAngle();
+        state->dynamic = (body_->GetType() != b2_staticBody);
+        state->modified = modified_;
+        state->generatedIndex = generatedIndex_;
+        state->localPolygon = localPolygon_;
+        copyGrid(grid_, state);
+        state->gridColors.clear();
+    }
+
     Box2 BlockPhysicsComponent::getBounds() const
     {
         if (grid_.isEmpty()) {
@@ -125,35 +194,112 @@ namespace crust {
         return localPolygon_.containsPoint(Vector2(localPoint.x, localPoint.y));
     }
     
-    void BlockPhysicsComponent::rasterize(Polygon2 const &polygon)
+    void BlockPhysicsComponent::createFixtures()
     {
-        Polygon2 localPolygon;
-        for (int i = 0; i < polygon.getSize(); ++i) {
-            b2Vec2 worldPoint(polygon.vertices[i].x, polygon.vertices[i].y);
-            b2Vec2 localPoint = body_->GetLocalPoint(worldPoint);
-            localPolygon.vertices.push_back(Vector2(localPoint.x, localPoint.y));
+        b2Vec2 vertices[b2_maxPolygonVertices];
+        int32 vertexCount = int32(localPolygon_.vertices.size());
+        for (int32 i = 0; i < vertexCount; ++i) {
+            vertices[i].Set(localPolygon_.vertices[i].x, localPolygon_.vertices[i].y);
+            radius_ = std::max(radius_, vertices[i].Length());
+        }
+        b2PolygonShape shape;
+        shape.Set(vertices, vertexCount);
+        b2FixtureDef fixtureDef;
+        fixtureDef.shape = &shape;
+        fixtureDef.density = 2.5f;
+        fixtureDef.filter.groupIndex = -1;
+        body_->CreateFixture(&fixtureDef);
+        
+        Polygon2 innerPolygon = localPolygon_;
+        innerPolygon.pad(-0.15f);
+        for (int32 i = 0; i < vertexCount; ++i) {
+            vertices[i].Set(innerPolygon.vertices[i].x, innerPolygon.vertices[i].y);
         }
+        b2PolygonShape innerShape;
+        innerShape.Set(vertices, vertexCount);
+        body_->CreateFixture(&innerShape, 0.0f);
+    }
+
+    // The polygon is convex, so the grid points inside it form one span per
+    // row. Intersecting the edges with the row gives the span up to rounding
+    // errors, which are fixed up with point tests at the ends.
+    void BlockPhysicsComponent::rasterize(Polygon2 const &localPolygon,
+                                          BitGrid *grid)
+    {
         Box2 bounds = localPolygon.getBoundingBox();
         int minX = int(10.0f * bounds.p1.x + 0.05f);
         int minY = int(10.0f * bounds.p1.y + 0.05f);
         int maxX = int(10.0f * bounds.p2.x + 0.05f);
         int maxY = int(10.0f * bounds.p2.y + 0.05f);
+        int vertexCount = localPolygon.getSize();
         for (int y = minY; y <= maxY; ++y) {
-            for (int x = minX; x <= maxX; ++x) {
-                Vector2 localPoint(0.1f * float(x), 0.1f * float(y));
-                if (localPolygon.containsPoint(localPoint)) {
-                    for (int dy = -1; dy <= 1; ++dy) {
-                        for (int dx = -1; dx <= 1; ++dx) {
-                            if (dx == 0 || dy == 0) {
-                                setElement(x + dx, y + dy, 1);
-                            }
-                        }
+            float localY = 0.1f * float(y);
+            float left = bounds.p2.x;
+            float right = bounds.p1.x;
+            for (int i = 0; i < vertexCount; ++i) {
+                Vector2 const &a = localPolygon.vertices[i];
+                Vector2 const &b = localPolygon.vertices[(i + 1) % vertexCount];
+                if (std::min(a.y, b.y) <= localY && localY <= std::max(a.y, b.y)) {
+                    float localX = a.x;
+                    if (a.y != b.y) {
+                        localX += (localY - a.y) * (b.x - a.x) / (b.y - a.y);
                     }
+                    left = std::min(left, localX);
+                    right = std::max(right, localX);
                 }
             }
+
+            int x1 = std::max(int(std::ceil(10.0f * left)), minX);
+            int x2 = std::min(int(std::floor(10.0f * right)), maxX);
+            while (minX < x1 && containsGridPoint(localPolygon, x1 - 1, y)) {
+                --x1;
+            }
+            while (x1 <= maxX && !containsGridPoint(localPolygon, x1, y)) {
+                ++x1;
+            }
+            x2 = std::max(x2, x1);
+            while (x2 < maxX && containsGridPoint(localPolygon, x2 + 1, y)) {
+                ++x2;
+            }
+            while (x1 <= x2 && !containsGridPoint(localPolygon, x2, y)) {
+                --x2;
+            }
+            if (x1 <= x2) {
+                grid->setSpan(y - 1, x1, x2);
+                grid->setSpan(y, x1 - 1, x2 + 1);
+                grid->setSpan(y + 1, x1, x2);
+            }
         }
     }
+
+    bool BlockPhysicsComponent::containsGridPoint(Polygon2 const &localPolygon,
+                                                  int x, int y)
+    {
+        return localPolygon.containsPoint(Vector2(0.1f * float(x), 0.1f * float(y)));
+    }
     
+    void BlockPhysicsComponent::copyGrid(BitGrid const &grid,
+                                         BlockState *state)
+    {
+        state->gridElements.clear();
+        if (grid.isEmpty()) {
+            state->gridBox = IntBox2();
+        } else {
+            int x = grid.getX();
+            int y = grid.getY();
+            int width = grid.getWidth();
+            int height = grid.getHeight();
+            state->gridBox = IntBox2(IntVector2(x, y),
+                                     IntVector2(x + width, y + height));
+            state->gridElements.reserve(width * height);
+            for (int dy = 0; dy < height; ++dy) {
+                for (int dx = 0; dx < width; ++dx) {
+                    state->gridElements.push_back(grid.getElement(x + dx, y + dy));
+                }
+            }
+        }
+    }
+
     void BlockPhysicsComponent::addGridPointToBounds(int x, int y, Box2 *bounds) const
     {
         b2Vec2 localPoint = b2Vec2(0.1f * float(x), 0.1f * float(y));
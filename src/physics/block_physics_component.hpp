@@ -3,8 +3,9 @@
 
 #include "component.hpp"
 
+#include "bit_grid.hpp"
+#include "block_state.hpp"
 #include "geometry.hpp"
-#include "grid.hpp"
 #include <Box2D/Box2D.h>
 
 namespace crust {
@@ -13,9 +14,23 @@ namespace crust {
     
     class BlockPhysicsComponent : public Component {
     public:
+        static Type const componentType = BLOCK_PHYSICS_TYPE;
+
         explicit BlockPhysicsComponent(Actor *actor, Polygon2 const &polygon);
+        explicit BlockPhysicsComponent(Actor *actor, BlockState const &state);
         ~BlockPhysicsComponent();
 
+        // Fills in the transform, local polygon and grid of a block with
+        // the given world polygon. Touches no game state, so it can run on
+        // any thread.
+        static void initState(Polygon2 const &polygon, float angle,
+                              BlockState *state);
+
+        Actor *getActor()
+        {
+            return actor_;
+        }
+
         b2Body *getBody()
         {
             return body_;
@@ -24,6 +39,9 @@ namespace crust {
         void create();
         void destroy();
 
+        void makeDynamic();
+        void makeStatic();
+
         int getElement(int x, int y);
         void setElement(int x, int y, int type);
         
@@ -31,15 +49,37 @@ namespace crust {
         int getElementAtPosition(float x, float y);
         void setElementAtPosition(float x, float y, int type);
         
+        // True if the block has been moved or edited since it was created
+        // from a polygon.
+        bool isModified() const
+        {
+            return modified_;
+        }
+
+        // Index among the blocks that the chunk generates, or -1.
+        int getGeneratedIndex() const
+        {
+            return generatedIndex_;
+        }
+
+        void getState(BlockState *state) const;
+
         Box2 getBounds() const;
         bool containsPoint(Vector2 const &point) const;
+
+        // Radius of a circle around the body origin that contains the
+        // block.
+        float getRadius() const
+        {
+            return radius_;
+        }
         
         Polygon2 const &getLocalPolygon() const
         {
             return localPolygon_;
         }
         
-        Grid<unsigned char> const &getGrid() const
+        BitGrid const &getGrid() const
         {
             return grid_;
         }
@@ -53,21 +93,57 @@ namespace crust {
         {
             mineDuration_ = duration;
         }
+
+        // Index in the block component array of the physics manager.
+        int getBlockIndex() const
+        {
+            return blockIndex_;
+        }
+
+        void setBlockIndex(int index)
+        {
+            blockIndex_ = index;
+        }
+
+        // Index in the active block component array of the physics manager,
+        // or -1 if the body is static.
+        int getActiveBlockIndex() const
+        {
+            return activeBlockIndex_;
+        }
+
+        void setActiveBlockIndex(int index)
+        {
+            activeBlockIndex_ = index;
+        }
         
     private:
         Actor *actor_;
         PhysicsManager *physicsManager_;
 
         Polygon2 polygon_;
+        BlockState state_;
+        bool stateValid_;
 
         Polygon2 localPolygon_;
         
-        Grid<unsigned char> grid_;
+        BitGrid grid_;
         b2Body *body_;
+        float radius_;
 
         float mineDuration_;
+        int blockIndex_;
+        int activeBlockIndex_;
+        bool modified_;
+        int generatedIndex_;
         
-        void rasterize(Polygon2 const &polygon);
+        void createFixtures();
+        static void rasterize(Polygon2 const &localPolygon,
+                              BitGrid *grid);
+        static bool containsGridPoint(Polygon2 const &localPolygon,
+                                      int x, int y);
+        static void copyGrid(BitGrid const &grid,
+                             BlockState *state);
         
         void addGridPointToBounds(int x, int y, Box2 *bounds) const;
     };
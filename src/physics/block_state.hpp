@@ -0,0 +1,44 @@
+#ifndef CRUST_BLOCK_STATE_HPP
+#define CRUST_BLOCK_STATE_HPP
+
+#include "color.hpp"
+#include "geometry.hpp"
+#include "int_geometry.hpp"
+
+#include <vector>
+
+namespace crust {
+    // Everything needed to create a block, either freshly generated or
+    // saved from an actor that has been destroyed, for example when the
+    // chunk that it is in is evicted.
+    class BlockState {
+    public:
+        Vector2 position;
+        float angle;
+        bool dynamic;
+
+        // Set if the block differs from the one that its chunk generates.
+        bool modified;
+
+        // Index among the blocks that the chunk generates, or -1 if the
+        // block was not generated by a chunk.
+        int generatedIndex;
+
+        Polygon2 localPolygon;
+
+        // Grid elements and their colors in row-major order. The colors
+        // are empty if they have not been generated yet.
+        IntBox2 gridBox;
+        std::vector<unsigned char> gridElements;
+        std::vector<Color3> gridColors;
+
+        BlockState() :
+            angle(0.0f),
+            dynamic(false),
+            modified(false),
+            generatedIndex(-1)
+        { }
+    };
+}
+
+#endif
@@ -7,6 +7,7 @@
 namespace crust {
     MonsterPhysicsComponent::MonsterPhysicsComponent(Actor *actor,
                                                      Vector2 const &position) :
+        Component(componentType),
         actor_(actor),
         physicsManager_(actor->getGame()->getPhysicsManager()),
         position_(position),
@@ -13,6 +13,8 @@ namespace crust {
     
     class MonsterPhysicsComponent : public Component {
     public:
+        static Type const componentType = MONSTER_PHYSICS_TYPE;
+
         MonsterPhysicsComponent(Actor *actor, Vector2 const &position);
         ~MonsterPhysicsComponent();
 
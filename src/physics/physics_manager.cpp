@@ -1,10 +1,15 @@
 #include "physics_manager.hpp"
 
+#include "block_physics_component.hpp"
+#include "game.hpp"
 #include "physics_draw_callback.hpp"
 
+#include <iterator>
+
 namespace crust {
     PhysicsManager::PhysicsManager(Game *game) :
-        game_(game)
+        game_(game),
+        blockHash_(2.0f)
     {
         b2Vec2 gravity(0.0f, -10.0f);
         world_.reset(new b2World(gravity));
@@ -18,6 +23,85 @@ namespace crust {
 
     void PhysicsManager::step(float dt)
     {
-        world_->Step(dt, 10, 10);
+        ProfileZone zone(game_->getProfiler(), "PHYSICS");
+        {
+            ProfileZone worldZone(game_->getProfiler(), "WORLD");
+            world_->Step(dt, 10, 10);
+        }
+        updateBlockHash();
+        freezeSleepingBlocks();
+    }
+
+    void PhysicsManager::addBlockComponent(BlockPhysicsComponent *component)
+    {
+        component->setBlockIndex(int(blockComponents_.size()));
+        blockComponents_.push_back(component);
+        b2Vec2 position = component->getBody()->GetPosition();
+        blockHash_.insert(component, Vector2(position.x, position.y),
+                          component->getRadius());
+    }
+
+    void PhysicsManager::removeBlockComponent(BlockPhysicsComponent *component)
+    {
+        int index = component->getBlockIndex();
+        blockComponents_[index] = blockComponents_.back();
+        blockComponents_[index]->setBlockIndex(index);
+        blockComponents_.pop_back();
+        component->setBlockIndex(-1);
+        blockHash_.remove(component);
+    }
+
+    void PhysicsManager::addActiveBlockComponent(BlockPhysicsComponent *component)
+    {
+        if (component->getActiveBlockIndex() == -1) {
+            component->setActiveBlockIndex(int(activeBlockComponents_.size()));
+            activeBlockComponents_.push_back(component);
+        }
+    }
+
+    void PhysicsManager::removeActiveBlockComponent(BlockPhysicsComponent *component)
+    {
+        int index = component->getActiveBlockIndex();
+        if (index != -1) {
+            activeBlockComponents_[index] = activeBlockComponents_.back();
+            activeBlockComponents_[index]->setActiveBlockIndex(index);
+            activeBlockComponents_.pop_back();
+            component->setActiveBlockIndex(-1);
+        }
+    }
+
+    void PhysicsManager::findBlockComponents(Box2 const &box,
+                                             BlockComponentVector *components) const
+    {
+        blockHash_.findValues(box, std::back_inserter(*components));
+    }
+
+    void PhysicsManager::findBlockComponents(Vector2 const &point,
+                                             BlockComponentVector *components) const
+    {
+        blockHash_.findValues(point, std::back_inserter(*components));
+    }
+
+    // Only blocks with non-static bodies can move, so only the active set
+    // needs to be refreshed.
+    void PhysicsManager::updateBlockHash()
+    {
+        for (std::size_t i = 0; i < activeBlockComponents_.size(); ++i) {
+            BlockPhysicsComponent *component = activeBlockComponents_[i];
+            b2Vec2 position = component->getBody()->GetPosition();
+            blockHash_.move(component, Vector2(position.x, position.y));
+        }
+    }
+
+    void PhysicsManager::freezeSleepingBlocks()
+    {
+        // Iterate backwards, since making a block static removes it from the
+        // active set.
+        for (int i = int(activeBlockComponents_.size()) - 1; i >= 0; --i) {
+            BlockPhysicsComponent *component = activeBlockComponents_[i];
+            if (!component->getBody()->IsAwake()) {
+                component->makeStatic();
+            }
+        }
     }
 }
@@ -1,15 +1,21 @@
 #ifndef CRUST_PHYSICS_MANAGER_HPP
 #define CRUST_PHYSICS_MANAGER_HPP
 
+#include "spatial_hash.hpp"
+
 #include <memory>
+#include <vector>
 #include <Box2D/Box2D.h>
 
 namespace crust {
+    class BlockPhysicsComponent;
     class Game;
     class PhysicsDrawCallback;
 
     class PhysicsManager : public b2ContactListener {
     public:
+        typedef std::vector<BlockPhysicsComponent *> BlockComponentVector;
+
         explicit PhysicsManager(Game *game);
         ~PhysicsManager();
 
@@ -25,6 +31,41 @@ namespace crust {
             return world_.get();
         }
 
+        int getBlockComponentCount() const
+        {
+            return int(blockComponents_.size());
+        }
+
+        BlockPhysicsComponent *getBlockComponent(int index)
+        {
+            return blockComponents_[index];
+        }
+
+        void addBlockComponent(BlockPhysicsComponent *component);
+        void removeBlockComponent(BlockPhysicsComponent *component);
+
+        // Blocks with non-static bodies. A block leaves the set when its
+        // body falls asleep and is made static again.
+        int getActiveBlockComponentCount() const
+        {
+            return int(activeBlockComponents_.size());
+        }
+
+        BlockPhysicsComponent *getActiveBlockComponent(int index)
+        {
+            return activeBlockComponents_[index];
+        }
+
+        void addActiveBlockComponent(BlockPhysicsComponent *component);
+        void removeActiveBlockComponent(BlockPhysicsComponent *component);
+
+        // Finds the blocks with bounding circles that overlap the box or
+        // contain the point. Callers refine the candidates further.
+        void findBlockComponents(Box2 const &box,
+                                 BlockComponentVector *components) const;
+        void findBlockComponents(Vector2 const &point,
+                                 BlockComponentVector *components) const;
+
         void BeginContact(b2Contact *contact)
         { }
 
@@ -35,6 +76,12 @@ namespace crust {
         Game *game_;
         std::auto_ptr<b2World> world_;
         std::auto_ptr<PhysicsDrawCallback> drawCallback_;
+        BlockComponentVector blockComponents_;
+        BlockComponentVector activeBlockComponents_;
+        SpatialHash<BlockPhysicsComponent *> blockHash_;
+
+        void updateBlockHash();
+        void freezeSleepingBlocks();
     };
 }
 
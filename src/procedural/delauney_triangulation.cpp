@@ -1,67 +1,267 @@
 #include "delauney_triangulation.hpp"
 
+#include <algorithm>
 #include <cmath>
-#include <map>
-#include <set>
+#include <utility>
 #include <SDL/SDL_opengl.h>
 
 namespace crust {
-    DelauneyTriangulation::DelauneyTriangulation(Box2 box)
+    namespace {
+        // http://en.wikipedia.org/wiki/Hilbert_curve
+        int getHilbertIndex(int size, int x, int y)
+        {
+            int index = 0;
+            for (int s = size / 2; s > 0; s /= 2) {
+                int rx = (x & s) > 0;
+                int ry = (y & s) > 0;
+                index += s * s * ((3 * rx) ^ ry);
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = s - 1 - x;
+                        y = s - 1 - y;
+                    }
+                    std::swap(x, y);
+                }
+            }
+            return index;
+        }
+    }
+
+    DelauneyTriangulation::DelauneyTriangulation(Box2 box) :
+        lastTriangle_(0),
+        mark_(0)
     {
         vertices_.push_back(box.p1);
         vertices_.push_back(Vector2(box.p2.x, box.p1.y));
         vertices_.push_back(box.p2);
         vertices_.push_back(Vector2(box.p1.x, box.p2.y));
-        IndexArray indices1 = { { 0, 1, 2 } };
-        triangles_.push_back(indices1);
-        IndexArray indices2 = { { 0, 2, 3 } };
-        triangles_.push_back(indices2);
+        triangles_.resize(2);
+        setTriangle(0, 0, 1, 2);
+        setTriangle(1, 0, 2, 3);
+        triangles_[0].neighbors[0] = -1;
+        triangles_[0].neighbors[1] = 1;
+        triangles_[0].neighbors[2] = -1;
+        triangles_[1].neighbors[0] = -1;
+        triangles_[1].neighbors[1] = -1;
+        triangles_[1].neighbors[2] = 0;
     }
 
     // http://en.wikipedia.org/wiki/Bowyer-Watson_algorithm
     void DelauneyTriangulation::addVertex(Vector2 vertex)    
     {
-        // Add vertex.
+        int triangle = findTriangle(vertex);
         vertices_.push_back(vertex);
+        if (triangle != -1) {
+            findCavity(triangle, vertex);
+            fillCavity(int(vertices_.size()) - 1);
+        }
+    }
+
+    void DelauneyTriangulation::addVertices(VertexVector const &vertices)
+    {
+        if (vertices.empty()) {
+            return;
+        }
+
+        Box2 bounds;
+        for (std::size_t i = 0; i < vertices.size(); ++i) {
+            bounds.mergePoint(vertices[i]);
+        }
+        int size = 1 << 15;
+        float scale = float(size - 1) / std::max(std::max(bounds.getWidth(),
+                                                          bounds.getHeight()),
+                                                 1e-6f);
+
+        std::vector<std::pair<int, int> > order;
+        for (std::size_t i = 0; i < vertices.size(); ++i) {
+            int x = int((vertices[i].x - bounds.p1.x) * scale);
+            int y = int((vertices[i].y - bounds.p1.y) * scale);
+            order.push_back(std::make_pair(getHilbertIndex(size, x, y), int(i)));
+        }
+        std::sort(order.begin(), order.end());
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            addVertex(vertices[order[i].second]);
+        }
+    }
+
+    void DelauneyTriangulation::setTriangle(int index, int v1, int v2, int v3)
+    {
+        Triangle &triangle = triangles_[index];
+        triangle.vertices[0] = v1;
+        triangle.vertices[1] = v2;
+        triangle.vertices[2] = v3;
+
+        // Use double precision, since the circumcircles of small triangles
+        // far from the origin are too inaccurate in single precision.
+        // http://en.wikipedia.org/wiki/Circumscribed_circle
+        double ax = vertices_[v1].x;
+        double ay = vertices_[v1].y;
+        double bx = double(vertices_[v2].x) - ax;
+        double by = double(vertices_[v2].y) - ay;
+        double cx = double(vertices_[v3].x) - ax;
+        double cy = double(vertices_[v3].y) - ay;
+        double d = 2.0 * (bx * cy - by * cx);
+        double b2 = bx * bx + by * by;
+        double c2 = cx * cx + cy * cy;
+        double ux = (cy * b2 - by * c2) / d;
+        double uy = (bx * c2 - cx * b2) / d;
+        triangle.circumcenterX = ax + ux;
+        triangle.circumcenterY = ay + uy;
+        triangle.squaredCircumradius = ux * ux + uy * uy;
+    }
+
+    bool DelauneyTriangulation::circumcircleContains(int index, Vector2 const &p) const
+    {
+        Triangle const &triangle = triangles_[index];
+        double dx = double(p.x) - triangle.circumcenterX;
+        double dy = double(p.y) - triangle.circumcenterY;
+        return dx * dx + dy * dy < triangle.squaredCircumradius;
+    }
+
+    // Walks from the last inserted triangle towards the point, crossing the
+    // first edge that has the point on its outside.
+    int DelauneyTriangulation::findTriangle(Vector2 const &p) const
+    {
+        int current = lastTriangle_;
+        int start = 0;
+        int stepCount = 0;
+        int maxStepCount = int(triangles_.size()) + 3;
+        while (stepCount < maxStepCount) {
+            Triangle const &triangle = triangles_[current];
+            int next = -1;
+            bool outside = false;
+            for (int j = 0; j < 3; ++j) {
+                // Start from a different edge each time, so that the walk
+                // can't cycle.
+                int i = (start + j) % 3;
+                Vector2 const &v1 = vertices_[triangle.vertices[(i + 1) % 3]];
+                Vector2 const &v2 = vertices_[triangle.vertices[(i + 2) % 3]];
+                if (cross(v2 - v1, p - v1) < 0.0f) {
+                    outside = true;
+                    next = triangle.neighbors[i];
+                    if (next != -1) {
+                        break;
+                    }
+                }
+            }
+            if (!outside) {
+                return current;
+            }
+            if (next == -1) {
+                break;
+            }
+            current = next;
+            start = (start + 1) % 3;
+            ++stepCount;
+        }
 
-        // Remove the triangles that have circumcircles that contain the new
-        // vertex. Remember the indices of the removed triangles.
-        std::set<int> uniqueIndices;
+        // The point is outside the hull. Fall back to a linear search, as
+        // the triangulation may still have to change around it.
         for (int i = 0; i < int(triangles_.size()); ++i) {
-            if (getTriangle(i).getCircumcircleDeterminant(vertex) > 0.0f) {
-                uniqueIndices.insert(triangles_[i][0]);
-                uniqueIndices.insert(triangles_[i][1]);
-                uniqueIndices.insert(triangles_[i][2]);
-                std::swap(triangles_[i], triangles_.back());
-                triangles_.pop_back();
-                --i;
+            if (circumcircleContains(i, p)) {
+                return i;
             }
         }
+        return -1;
+    }
 
-        // Sort the indices by angle relative to the new vertex.
-        std::multimap<float, int> sortedIndices;
-        for (std::set<int>::iterator i = uniqueIndices.begin();
-             i != uniqueIndices.end(); ++i)
-        {
-            Vector2 diff = getVertex(*i) - vertex;
-            float angle = std::atan2(diff.y, diff.x);
-            sortedIndices.insert(std::make_pair(angle, *i));
+    // Flood fills from the triangle that contains the point, across the
+    // neighbors with circumcircles that contain the point.
+    void DelauneyTriangulation::findCavity(int triangle, Vector2 const &p)
+    {
+        marks_.resize(triangles_.size(), 0);
+        mark_ += 2;
+        int visitedMark = mark_;
+        int cavityMark = mark_ + 1;
+
+        cavity_.clear();
+        stack_.clear();
+        marks_[triangle] = cavityMark;
+        stack_.push_back(triangle);
+        while (!stack_.empty()) {
+            int current = stack_.back();
+            stack_.pop_back();
+            cavity_.push_back(current);
+            for (int i = 0; i < 3; ++i) {
+                int neighbor = triangles_[current].neighbors[i];
+                if (neighbor != -1 && marks_[neighbor] < visitedMark) {
+                    if (circumcircleContains(neighbor, p)) {
+                        marks_[neighbor] = cavityMark;
+                        stack_.push_back(neighbor);
+                    } else {
+                        marks_[neighbor] = visitedMark;
+                    }
+                }
+            }
         }
 
-        // Create new triangles from the new vertex and the sorted indices.
-        for (std::multimap<float, int>::iterator i = sortedIndices.begin();
-             i != sortedIndices.end(); ++i)
-        {
-            std::multimap<float, int>::iterator j = i;
-            ++j;
-            if (j == sortedIndices.end()) {
-                j = sortedIndices.begin();
+        // Collect the boundary edges in counterclockwise order as seen from
+        // inside of the cavity.
+        edges_.clear();
+        for (std::size_t i = 0; i < cavity_.size(); ++i) {
+            Triangle const &triangle = triangles_[cavity_[i]];
+            for (int j = 0; j < 3; ++j) {
+                int neighbor = triangle.neighbors[j];
+                if (neighbor == -1 || marks_[neighbor] != cavityMark) {
+                    edges_.push_back(Edge(triangle.vertices[(j + 1) % 3],
+                                          triangle.vertices[(j + 2) % 3],
+                                          neighbor));
+                }
+            }
+        }
+    }
+
+    // Connects the new vertex to each boundary edge of the cavity. The
+    // triangles of the cavity are reused, so that the array stays dense.
+    void DelauneyTriangulation::fillCavity(int vertex)
+    {
+        newTriangles_.clear();
+        for (std::size_t i = 0; i < edges_.size(); ++i) {
+            int index = 0;
+            if (i < cavity_.size()) {
+                index = cavity_[i];
+            } else {
+                index = int(triangles_.size());
+                triangles_.push_back(Triangle());
+            }
+            newTriangles_.push_back(index);
+        }
+        marks_.resize(triangles_.size(), 0);
+
+        for (std::size_t i = 0; i < edges_.size(); ++i) {
+            Edge const &edge = edges_[i];
+            int index = newTriangles_[i];
+            setTriangle(index, vertex, edge.v1, edge.v2);
+            triangles_[index].neighbors[0] = edge.neighbor;
+            if (edge.neighbor != -1) {
+                replaceNeighbor(edge.neighbor, edge.v2, edge.v1, index);
+            }
+        }
+
+        // Each boundary vertex starts exactly one boundary edge and ends
+        // exactly one, which links the new triangles around the vertex.
+        for (std::size_t i = 0; i < edges_.size(); ++i) {
+            for (std::size_t j = 0; j < edges_.size(); ++j) {
+                if (edges_[i].v2 == edges_[j].v1) {
+                    triangles_[newTriangles_[i]].neighbors[1] = newTriangles_[j];
+                    triangles_[newTriangles_[j]].neighbors[2] = newTriangles_[i];
+                    break;
+                }
+            }
+        }
+
+        lastTriangle_ = newTriangles_.back();
+    }
+
+    void DelauneyTriangulation::replaceNeighbor(int triangle, int v1, int v2,
+                                                int neighbor)
+    {
+        Triangle &t = triangles_[triangle];
+        for (int i = 0; i < 3; ++i) {
+            if (t.vertices[(i + 1) % 3] == v1 && t.vertices[(i + 2) % 3] == v2) {
+                t.neighbors[i] = neighbor;
+                return;
             }
-            int v1 = int(vertices_.size()) - 1;
-            int v2 = i->second;
-            int v3 = j->second;
-            IndexArray triangle = { { v1, v2, v3 } };
-            triangles_.push_back(triangle);
         }
     }
 
@@ -12,9 +12,14 @@ namespace crust {
         explicit DelauneyTriangulation(Box2 box);
 
         typedef boost::array<int, 3> IndexArray;
+        typedef std::vector<Vector2> VertexVector;
 
         void addVertex(Vector2 vertex);
 
+        // Adds the vertices along a Hilbert curve, so that each vertex is
+        // usually found a few steps away from the previous one.
+        void addVertices(VertexVector const &vertices);
+
         int getVertexCount() const
         {
             return int(vertices_.size());
@@ -30,27 +35,79 @@ namespace crust {
             return int(triangles_.size());
         }
 
+        // Vertex indices in counterclockwise order.
         IndexArray getTriangleIndices(int index) const
         {
-            return triangles_[index];
+            return triangles_[index].vertices;
+        }
+
+        // Index of the neighbor opposite each vertex, or -1 on the hull.
+        IndexArray getTriangleNeighbors(int index) const
+        {
+            return triangles_[index].neighbors;
         }
         
         Triangle2 getTriangle(int index) const
         {
-            Vector2 v1 = vertices_[triangles_[index][0]];
-            Vector2 v2 = vertices_[triangles_[index][1]];
-            Vector2 v3 = vertices_[triangles_[index][2]];
-            return Triangle2(v1, v2, v3);
+            IndexArray const &indices = triangles_[index].vertices;
+            return Triangle2(vertices_[indices[0]], vertices_[indices[1]],
+                             vertices_[indices[2]]);
+        }
+
+        Vector2 getCircumcenter(int index) const
+        {
+            return Vector2(float(triangles_[index].circumcenterX),
+                           float(triangles_[index].circumcenterY));
         }
 
         void draw();
         
     private:
-        typedef std::vector<Vector2> VertexVector;
-        typedef std::vector<IndexArray> TriangleVector;
+        class Triangle {
+        public:
+            IndexArray vertices;
+            IndexArray neighbors;
+            double circumcenterX;
+            double circumcenterY;
+            double squaredCircumradius;
+        };
+
+        class Edge {
+        public:
+            int v1;
+            int v2;
+            int neighbor;
+
+            Edge(int v1, int v2, int neighbor) :
+                v1(v1),
+                v2(v2),
+                neighbor(neighbor)
+            { }
+        };
+
+        typedef std::vector<Triangle> TriangleVector;
+        typedef std::vector<Edge> EdgeVector;
+        typedef std::vector<int> IndexVector;
 
         VertexVector vertices_;
         TriangleVector triangles_;
+        int lastTriangle_;
+
+        // Scratch state for insertion, kept between calls to avoid
+        // allocations.
+        IndexVector marks_;
+        int mark_;
+        IndexVector cavity_;
+        IndexVector stack_;
+        EdgeVector edges_;
+        IndexVector newTriangles_;
+
+        void setTriangle(int index, int v1, int v2, int v3);
+        bool circumcircleContains(int index, Vector2 const &p) const;
+        int findTriangle(Vector2 const &p) const;
+        void findCavity(int triangle, Vector2 const &p);
+        void fillCavity(int vertex);
+        void replaceNeighbor(int triangle, int v1, int v2, int neighbor);
 
         void drawVertices();
         void drawTriangles();
@@ -1,7 +1,11 @@
 #include "dungeon_generator.hpp"
 
+#include "delauney_triangulation.hpp"
 #include "random.hpp"
 
+#include <algorithm>
+#include <iterator>
+
 namespace crust {
     DungeonGenerator::DungeonGenerator(Random *random, Box2 const &bounds) :
         random_(random),
@@ -10,7 +14,10 @@ namespace crust {
         maxRoomSize_(7.0f),
         wallSize_(1.0f),
         corridorWidth_(2.0f),
-        corridorHeight_(2.0f)
+        corridorHeight_(2.0f),
+        minRoomAttemptCount_(500),
+        roomAttemptDensity_(500.0f / (28.0f * 28.0f)),
+        roomHash_(maxRoomSize_)
     {
         bounds_.pad(Vector2(-wallSize_, -wallSize_));
     }
@@ -19,13 +26,19 @@ namespace crust {
     {
         roomBoxes_.clear();
         corridorBoxes_.clear();
+        roomHash_.clear();
         generateRooms();
         generateCorridors();
     }
 
+    // The number of attempts grows with the area, so that large bounds
+    // are as densely packed as small ones. Bounds up to the old 28x28,
+    // including the chunks, keep the old fixed count.
     void DungeonGenerator::generateRooms()
     {
-        for (int i = 0; i < 500; ++i) {
+        int attemptCount = std::max(minRoomAttemptCount_,
+                                    int(roomAttemptDensity_ * bounds_.getArea() + 0.5f));
+        for (int i = 0; i < attemptCount; ++i) {
             generateRoom();
         }
     }
@@ -44,20 +57,50 @@ namespace crust {
             Vector2 p2(x + width, y + height);
             Box2 box(p1, p2);
             if (!intersectsRoom(box)) {
+                roomHash_.insert(int(roomBoxes_.size()), box.getCenter(),
+                                 0.5f * box.getSize().getLength());
                 roomBoxes_.push_back(box);
             }
         }
     }
 
+    // Only neighbors in the Delaunay triangulation of the room centers are
+    // candidates. A corridor between rooms that are further apart would
+    // almost always pass through a third room.
     void DungeonGenerator::generateCorridors()
     {
+        if (roomBoxes_.size() < 2) {
+            return;
+        }
+
+        Box2 triangulationBounds = bounds_;
+        triangulationBounds.pad(std::max(bounds_.getWidth(), bounds_.getHeight()));
+        DelauneyTriangulation triangulation(triangulationBounds);
         for (std::size_t i = 0; i < roomBoxes_.size(); ++i) {
-            for (std::size_t j = 0; j < roomBoxes_.size(); ++j) {
-                if (i < j) {
-                    generateCorridor(roomBoxes_[i], roomBoxes_[j]);
+            triangulation.addVertex(roomBoxes_[i].getCenter());
+        }
+
+        // The first four vertices are the corners of the triangulation
+        // bounds.
+        roomPairs_.clear();
+        for (int i = 0; i < triangulation.getTriangleCount(); ++i) {
+            DelauneyTriangulation::IndexArray indices = triangulation.getTriangleIndices(i);
+            for (int j = 0; j < 3; ++j) {
+                int a = indices[j] - 4;
+                int b = indices[(j + 1) % 3] - 4;
+                if (0 <= a && 0 <= b) {
+                    roomPairs_.push_back(std::make_pair(std::min(a, b),
+                                                        std::max(a, b)));
                 }
             }
         }
+        std::sort(roomPairs_.begin(), roomPairs_.end());
+        roomPairs_.erase(std::unique(roomPairs_.begin(), roomPairs_.end()),
+                         roomPairs_.end());
+        for (std::size_t i = 0; i < roomPairs_.size(); ++i) {
+            generateCorridor(roomBoxes_[roomPairs_[i].first],
+                             roomBoxes_[roomPairs_[i].second]);
+        }
     }
     
     bool DungeonGenerator::generateCorridor(Box2 const &a, Box2 const &b)
@@ -114,9 +157,11 @@ namespace crust {
     {
         Box2 paddedBox(box);
         paddedBox.pad(Vector2(wallSize_, wallSize_));
+        candidateRooms_.clear();
+        roomHash_.findValues(paddedBox, std::back_inserter(candidateRooms_));
         int count = 0;
-        for (std::size_t i = 0; i < roomBoxes_.size(); ++i) {
-            if (intersects(paddedBox, roomBoxes_[i])) {
+        for (std::size_t i = 0; i < candidateRooms_.size(); ++i) {
+            if (intersects(paddedBox, roomBoxes_[candidateRooms_[i]])) {
                 ++count;
             }
         }
@@ -2,7 +2,9 @@
 #define CRUST_DUNGEON_GENERATOR_HPP
 
 #include "geometry.hpp"
+#include "spatial_hash.hpp"
 
+#include <utility>
 #include <vector>
 
 namespace crust {
@@ -42,9 +44,18 @@ namespace crust {
         float wallSize_;
         float corridorWidth_;
         float corridorHeight_;
+        int minRoomAttemptCount_;
+        float roomAttemptDensity_;
         std::vector<Box2> roomBoxes_;
         std::vector<Box2> corridorBoxes_;
 
+        // Room indices by room center.
+        SpatialHash<int> roomHash_;
+
+        // Scratch state, kept between calls to avoid allocations.
+        std::vector<int> candidateRooms_;
+        std::vector<std::pair<int, int> > roomPairs_;
+
         void generateRooms();
         void generateRoom();
         void generateCorridors();
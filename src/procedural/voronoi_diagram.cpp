@@ -2,83 +2,82 @@
 
 #include "delauney_triangulation.hpp"
 
-#include <map>
-#include <set>
 #include <SDL/SDL_opengl.h>
 
 namespace crust {
-    Polygon2 VoronoiDiagram::getPolygon(int index)
+    void VoronoiDiagram::getPolygon(int index, Polygon2 *result) const
     {
-        Polygon2 result;
-        IndexVector const &indices = polygons_[index];
-        for (std::size_t i = 0; i < indices.size(); ++i) {
-            result.vertices.push_back(vertices_[indices[i]]);
+        result->vertices.clear();
+        for (int i = polygonOffsets_[index]; i < polygonOffsets_[index + 1]; ++i) {
+            result->vertices.push_back(vertices_[polygonIndices_[i]]);
         }
-        return result;
     }
 
     void VoronoiDiagram::generate(DelauneyTriangulation const &source)
     {
-        typedef std::map<int, IndexVector> TriangleMap;
+        typedef DelauneyTriangulation::IndexArray IndexArray;
 
         // Clear old state.
         vertices_.clear();
-        polygons_.clear();
+        polygonOffsets_.clear();
+        polygonIndices_.clear();
 
         // Store the circumcenter of each source triangle.
-        for (int i = 0; i < source.getTriangleCount(); ++i) {
-            Triangle2 triangle = source.getTriangle(i);
-            Vector2 circumcenter = triangle.getCircumcircle().center;
-            vertices_.push_back(circumcenter);
+        int triangleCount = source.getTriangleCount();
+        vertices_.reserve(triangleCount);
+        for (int i = 0; i < triangleCount; ++i) {
+            vertices_.push_back(source.getCircumcenter(i));
         }
 
-        // Map each source vertex to its adjacent source triangles.
-        TriangleMap triangles;
-        for (int i = 0; i < source.getTriangleCount(); ++i) {
-            DelauneyTriangulation::IndexArray indices =
-                source.getTriangleIndices(i);
-            triangles[indices[0]].push_back(i);
-            triangles[indices[1]].push_back(i);
-            triangles[indices[2]].push_back(i);
+        // Find a triangle for each source vertex.
+        IndexVector vertexTriangles(source.getVertexCount(), -1);
+        for (int i = 0; i < triangleCount; ++i) {
+            IndexArray indices = source.getTriangleIndices(i);
+            for (int j = 0; j < 3; ++j) {
+                vertexTriangles[indices[j]] = i;
+            }
         }
 
-        // Generate a polygon for each source vertex.
-        for (TriangleMap::iterator i = triangles.begin(); i != triangles.end();
-             ++i)
-        {
-            typedef std::multimap<float, int> SortedIndexMap;
-
-            Vector2 vertex = source.getVertex(i->first);
-            IndexVector const &triangleIndices = i->second;
-            
-            // Sort the circumcenters by angle relative to the source vertex.
-            SortedIndexMap sortedIndices;
-            for (IndexVector::const_iterator j = triangleIndices.begin();
-                 j != triangleIndices.end(); ++j)
-            {
-                Vector2 diff = vertices_[*j] - vertex;
-                float angle = std::atan2(diff.y, diff.x);
-                sortedIndices.insert(std::make_pair(angle, *j));
-            }
+        // Generate a polygon for each source vertex by visiting the
+        // triangles around it in counterclockwise order.
+        polygonOffsets_.reserve(source.getVertexCount() + 1);
+        polygonIndices_.reserve(3 * triangleCount);
+        polygonOffsets_.push_back(0);
+        for (int i = 0; i < source.getVertexCount(); ++i) {
+            int first = vertexTriangles[i];
+            if (first != -1) {
+                // On the hull, the triangles around the vertex don't form a
+                // closed fan. Start from the clockwise end instead.
+                int triangle = first;
+                do {
+                    IndexArray indices = source.getTriangleIndices(triangle);
+                    int k = (indices[0] == i) ? 0 : (indices[1] == i) ? 1 : 2;
+                    int previous = source.getTriangleNeighbors(triangle)[(k + 2) % 3];
+                    if (previous == -1) {
+                        first = triangle;
+                        break;
+                    }
+                    triangle = previous;
+                } while (triangle != first);
 
-            // Create polygon.
-            IndexVector polygonIndices;
-            for (SortedIndexMap::iterator i = sortedIndices.begin();
-                 i != sortedIndices.end(); ++i)
-            {
-                polygonIndices.push_back(i->second);
+                triangle = first;
+                do {
+                    polygonIndices_.push_back(triangle);
+                    IndexArray indices = source.getTriangleIndices(triangle);
+                    int k = (indices[0] == i) ? 0 : (indices[1] == i) ? 1 : 2;
+                    triangle = source.getTriangleNeighbors(triangle)[(k + 1) % 3];
+                } while (triangle != -1 && triangle != first);
             }
-            polygons_.push_back(polygonIndices);
+            polygonOffsets_.push_back(int(polygonIndices_.size()));
         }
     }
 
     void VoronoiDiagram::draw()
     {
-        for (std::size_t i = 0; i < polygons_.size(); ++i) {
-            IndexVector const &indices = polygons_[i];
+        for (int i = 0; i < getPolygonCount(); ++i) {
             glBegin(GL_LINE_LOOP);
-            for (std::size_t j = 0; j < indices.size(); ++j) {
-                Vector2 vertex = vertices_[indices[j]];
+            for (int j = polygonOffsets_[i]; j < polygonOffsets_[i + 1]; ++j) {
+                Vector2 vertex = vertices_[polygonIndices_[j]];
                 glVertex2f(vertex.x, vertex.y);
             }
             glEnd();
@@ -3,9 +3,14 @@
 
 #include "geometry.hpp"
 
+#include <vector>
+
 namespace crust {
     class DelauneyTriangulation;
 
+    // Voronoi diagram with one vertex per source triangle and one polygon
+    // per source vertex. The polygons are stored as ranges in a single
+    // index array.
     class VoronoiDiagram {
     public:
         int getVertexCount() const
@@ -20,20 +25,22 @@ namespace crust {
         
         int getPolygonCount() const
         {
-            return int(polygons_.size());
+            return int(polygonOffsets_.size()) - 1;
         }
 
         int getPolygonIndexCount(int index) const
         {
-            return int(polygons_[index].size());
+            return polygonOffsets_[index + 1] - polygonOffsets_[index];
         }
 
         int getPolygonIndex(int polygonIndex, int indexIndex) const
         {
-            return polygons_[polygonIndex][indexIndex];
+            return polygonIndices_[polygonOffsets_[polygonIndex] + indexIndex];
         }
         
-        Polygon2 getPolygon(int index);
+        // Replaces the vertices of the result with the polygon vertices in
+        // counterclockwise order.
+        void getPolygon(int index, Polygon2 *result) const;
 
         void generate(DelauneyTriangulation const &source);
 
@@ -42,10 +49,10 @@ namespace crust {
     private:
         typedef std::vector<Vector2> VertexVector;
         typedef std::vector<int> IndexVector;
-        typedef std::vector<IndexVector> PolygonVector;
 
         VertexVector vertices_;
-        PolygonVector polygons_;
+        IndexVector polygonOffsets_;
+        IndexVector polygonIndices_;
     };
 }
 
@@ -0,0 +1,118 @@
+#include "profiler.hpp"
+
+#include "tracer.hpp"
+
+#include <algorithm>
+
+namespace crust {
+    Profiler::Profiler(int historySize) :
+        historySize_(historySize),
+        historyIndex_(0),
+        historyCount_(0),
+        millisecondsPerCount_(1000.0 / double(SDL_GetPerformanceFrequency())),
+        currentZone_(-1),
+        tracer_(0)
+    {
+        zones_.push_back(Zone("FRAME", -1, 0));
+        zones_.back().history.resize(historySize_, 0.0f);
+    }
+
+    void Profiler::beginFrame()
+    {
+        for (ZoneVector::iterator i = zones_.begin(); i != zones_.end(); ++i) {
+            i->frameCounter = 0;
+        }
+        currentZone_ = 0;
+        zones_[0].startCounter = SDL_GetPerformanceCounter();
+    }
+
+    void Profiler::endFrame()
+    {
+        Uint64 counter = SDL_GetPerformanceCounter();
+        zones_[0].frameCounter += counter - zones_[0].startCounter;
+        if (tracer_) {
+            tracer_->addEvent(zones_[0].name, zones_[0].startCounter, counter);
+        }
+        currentZone_ = -1;
+        for (ZoneVector::iterator i = zones_.begin(); i != zones_.end(); ++i) {
+            i->history[historyIndex_] = float(double(i->frameCounter) * millisecondsPerCount_);
+        }
+        historyIndex_ = (historyIndex_ + 1) % historySize_;
+        historyCount_ = std::min(historyCount_ + 1, historySize_);
+    }
+
+    void Profiler::beginZone(char const *name)
+    {
+        if (currentZone_ == -1) {
+            // Outside of a frame.
+            return;
+        }
+        currentZone_ = findZone(name, currentZone_);
+        zones_[currentZone_].startCounter = SDL_GetPerformanceCounter();
+    }
+
+    void Profiler::endZone()
+    {
+        if (currentZone_ <= 0) {
+            return;
+        }
+        Zone &zone = zones_[currentZone_];
+        Uint64 counter = SDL_GetPerformanceCounter();
+        zone.frameCounter += counter - zone.startCounter;
+        if (tracer_) {
+            tracer_->addEvent(zone.name, zone.startCounter, counter);
+        }
+        currentZone_ = zone.parent;
+    }
+
+    ProfileStats Profiler::getZoneStats(int index) const
+    {
+        ProfileStats stats;
+        if (historyCount_ == 0) {
+            return stats;
+        }
+
+        std::vector<float> times(zones_[index].history.begin(),
+                                 zones_[index].history.begin() + historyCount_);
+        std::sort(times.begin(), times.end());
+        float total = 0.0f;
+        for (std::size_t i = 0; i < times.size(); ++i) {
+            total += times[i];
+        }
+        int last = historyCount_ - 1;
+        stats.min = times.front();
+        stats.average = total / float(historyCount_);
+        stats.max = times.back();
+        stats.median = times[last / 2];
+        stats.percentile95 = times[last * 95 / 100];
+        stats.percentile99 = times[last * 99 / 100];
+        return stats;
+    }
+
+    int Profiler::findZone(char const *name, int parent)
+    {
+        // Children follow their parent, so that the zones stay in
+        // depth-first order.
+        int end = parent + 1;
+        while (end < int(zones_.size()) &&
+               zones_[end].depth > zones_[parent].depth)
+        {
+            if (zones_[end].parent == parent && zones_[end].name == name) {
+                return end;
+            }
+            ++end;
+        }
+
+        Zone zone(name, parent, zones_[parent].depth + 1);
+        zone.history.resize(historySize_, 0.0f);
+        zones_.insert(zones_.begin() + end, zone);
+
+        // Fix the parents of the zones that were moved.
+        for (int i = end + 1; i < int(zones_.size()); ++i) {
+            if (zones_[i].parent >= end) {
+                ++zones_[i].parent;
+            }
+        }
+        return end;
+    }
+}
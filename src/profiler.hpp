@@ -0,0 +1,128 @@
+#ifndef CRUST_PROFILER_HPP
+#define CRUST_PROFILER_HPP
+
+#include <vector>
+#include <SDL/SDL.h>
+
+namespace crust {
+    class Tracer;
+
+    class ProfileStats {
+    public:
+        float min;
+        float average;
+        float max;
+        float median;
+        float percentile95;
+        float percentile99;
+
+        ProfileStats() :
+            min(0.0f),
+            average(0.0f),
+            max(0.0f),
+            median(0.0f),
+            percentile95(0.0f),
+            percentile99(0.0f)
+        { }
+    };
+
+    // Hierarchical frame profiler. Zones are identified by their name and
+    // their parent zone, and their time is summed over each frame. The
+    // profiler keeps the frame times of the last frames for each zone.
+    class Profiler {
+    public:
+        explicit Profiler(int historySize = 120);
+
+        // Zones are also recorded as trace events if there is a tracer.
+        void setTracer(Tracer *tracer)
+        {
+            tracer_ = tracer;
+        }
+
+        void beginFrame();
+        void endFrame();
+
+        // Zone names must be string literals or otherwise outlive the
+        // profiler, since they are compared and stored by pointer.
+        void beginZone(char const *name);
+        void endZone();
+
+        // Zones in depth-first order.
+        int getZoneCount() const
+        {
+            return int(zones_.size());
+        }
+
+        char const *getZoneName(int index) const
+        {
+            return zones_[index].name;
+        }
+
+        int getZoneDepth(int index) const
+        {
+            return zones_[index].depth;
+        }
+
+        // Statistics in milliseconds over the recorded frames.
+        ProfileStats getZoneStats(int index) const;
+
+    private:
+        class Zone {
+        public:
+            char const *name;
+            int parent;
+            int depth;
+            Uint64 startCounter;
+            Uint64 frameCounter;
+            std::vector<float> history;
+
+            Zone(char const *name, int parent, int depth) :
+                name(name),
+                parent(parent),
+                depth(depth),
+                startCounter(0),
+                frameCounter(0)
+            { }
+        };
+
+        typedef std::vector<Zone> ZoneVector;
+
+        int historySize_;
+        int historyIndex_;
+        int historyCount_;
+        double millisecondsPerCount_;
+        ZoneVector zones_;
+        int currentZone_;
+        Tracer *tracer_;
+
+        int findZone(char const *name, int parent);
+    };
+
+    // Times the enclosing scope as a zone of the profiler, if any.
+    class ProfileZone {
+    public:
+        ProfileZone(Profiler *profiler, char const *name) :
+            profiler_(profiler)
+        {
+            if (profiler_) {
+                profiler_->beginZone(name);
+            }
+        }
+
+        ~ProfileZone()
+        {
+            if (profiler_) {
+                profiler_->endZone();
+            }
+        }
+
+    private:
+        Profiler *profiler_;
+
+        // Noncopyable.
+        ProfileZone(ProfileZone const &other);
+        ProfileZone &operator=(ProfileZone const &other);
+    };
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef CRUST_SPATIAL_HASH_HPP
+#define CRUST_SPATIAL_HASH_HPP
+
+#include "geometry.hpp"
+#include "hash.hpp"
+#include "int_math.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+namespace crust {
+    // Uniform grid of hashed cells for looking up values by position. Each
+    // value is a point with a bounding radius and lives in the single cell
+    // that contains the point. Queries visit the cells that overlap the
+    // query region padded by the largest radius in the hash.
+    template <typename T>
+    class SpatialHash {
+    public:
+        typedef T Value;
+
+        explicit SpatialHash(float cellSize = 1.0f) :
+            cellSize_(cellSize),
+            invCellSize_(1.0f / cellSize),
+            maxRadius_(0.0f)
+        { }
+
+        int getSize() const
+        {
+            return int(valueCells_.size());
+        }
+
+        bool isEmpty() const
+        {
+            return valueCells_.empty();
+        }
+
+        bool contains(Value const &value) const
+        {
+            return valueCells_.find(value) != valueCells_.end();
+        }
+
+        void clear()
+        {
+            cells_.clear();
+            valueCells_.clear();
+            maxRadius_ = 0.0f;
+        }
+
+        void insert(Value const &value, Vector2 const &position, float radius)
+        {
+            IntVector2 cell = getCell(position);
+            cells_[cell].push_back(Entry(value, position, radius));
+            valueCells_[value] = cell;
+            maxRadius_ = std::max(maxRadius_, radius);
+        }
+
+        void remove(Value const &value)
+        {
+            typename ValueCellMap::iterator i = valueCells_.find(value);
+            if (i != valueCells_.end()) {
+                typename CellMap::iterator j = cells_.find(i->second);
+                EntryVector &entries = j->second;
+                entries[findEntry(entries, value)] = entries.back();
+                entries.pop_back();
+                if (entries.empty()) {
+                    cells_.erase(j);
+                }
+                valueCells_.erase(i);
+            }
+        }
+
+        // Moves a value that is already in the hash, keeping its radius.
+        void move(Value const &value, Vector2 const &position)
+        {
+            typename ValueCellMap::iterator i = valueCells_.find(value);
+            if (i == valueCells_.end()) {
+                return;
+            }
+            IntVector2 cell = getCell(position);
+            EntryVector &entries = cells_.find(i->second)->second;
+            int index = findEntry(entries, value);
+            if (cell == i->second) {
+                entries[index].position = position;
+            } else {
+                float radius = entries[index].radius;
+                remove(value);
+                insert(value, position, radius);
+            }
+        }
+
+        // Moves a value that is already in the hash and changes its radius.
+        void move(Value const &value, Vector2 const &position, float radius)
+        {
+            typename ValueCellMap::iterator i = valueCells_.find(value);
+            if (i == valueCells_.end()) {
+                return;
+            }
+            IntVector2 cell = getCell(position);
+            if (cell == i->second) {
+                EntryVector &entries = cells_.find(i->second)->second;
+                Entry &entry = entries[findEntry(entries, value)];
+                entry.position = position;
+                entry.radius = radius;
+                maxRadius_ = std::max(maxRadius_, radius);
+            } else {
+                remove(value);
+                insert(value, position, radius);
+            }
+        }
+
+        // Finds the values with bounding circles that may overlap the box.
+        template <typename OutputIterator>
+        void findValues(Box2 const &box, OutputIterator output) const
+        {
+            IntVector2 minCell = getCell(box.p1 - Vector2(maxRadius_));
+            IntVector2 maxCell = getCell(box.p2 + Vector2(maxRadius_));
+            for (int y = minCell.y; y <= maxCell.y; ++y) {
+                for (int x = minCell.x; x <= maxCell.x; ++x) {
+                    typename CellMap::const_iterator i = cells_.find(IntVector2(x, y));
+                    if (i != cells_.end()) {
+                        EntryVector const &entries = i->second;
+                        for (std::size_t j = 0; j < entries.size(); ++j) {
+                            Entry const &entry = entries[j];
+                            Box2 entryBox(entry.position - Vector2(entry.radius),
+                                          entry.position + Vector2(entry.radius));
+                            if (intersects(box, entryBox)) {
+                                *output++ = entry.value;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Finds the values with bounding circles that contain the point.
+        template <typename OutputIterator>
+        void findValues(Vector2 const &point, OutputIterator output) const
+        {
+            IntVector2 minCell = getCell(point - Vector2(maxRadius_));
+            IntVector2 maxCell = getCell(point + Vector2(maxRadius_));
+            for (int y = minCell.y; y <= maxCell.y; ++y) {
+                for (int x = minCell.x; x <= maxCell.x; ++x) {
+                    typename CellMap::const_iterator i = cells_.find(IntVector2(x, y));
+                    if (i != cells_.end()) {
+                        EntryVector const &entries = i->second;
+                        for (std::size_t j = 0; j < entries.size(); ++j) {
+                            Entry const &entry = entries[j];
+                            if (getSquaredDistance(entry.position, point) <=
+                                square(entry.radius))
+                            {
+                                *output++ = entry.value;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        class Entry {
+        public:
+            Value value;
+            Vector2 position;
+            float radius;
+
+            Entry(Value const &value, Vector2 const &position, float radius) :
+                value(value),
+                position(position),
+                radius(radius)
+            { }
+        };
+
+        class CellHash {
+        public:
+            std::size_t operator()(IntVector2 const &cell) const
+            {
+                return hashValue(hashValue(std::size_t(cell.x)) ^
+                                 std::size_t(cell.y));
+            }
+        };
+
+        typedef std::vector<Entry> EntryVector;
+        typedef boost::unordered_map<IntVector2, EntryVector, CellHash> CellMap;
+        typedef boost::unordered_map<Value, IntVector2> ValueCellMap;
+
+        float cellSize_;
+        float invCellSize_;
+        float maxRadius_;
+        CellMap cells_;
+        ValueCellMap valueCells_;
+
+        IntVector2 getCell(Vector2 const &position) const
+        {
+            return IntVector2(int(std::floor(position.x * invCellSize_)),
+                              int(std::floor(position.y * invCellSize_)));
+        }
+
+        static int findEntry(EntryVector const &entries, Value const &value)
+        {
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                if (entries[i].value == value) {
+                    return int(i);
+                }
+            }
+            return -1;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "tracer.hpp"
+
+#include "error.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace crust {
+    Tracer::Tracer(int capacity) :
+        capacity_(capacity),
+        startCounter_(SDL_GetPerformanceCounter()),
+        microsecondsPerCount_(1000000.0 / double(SDL_GetPerformanceFrequency()))
+    {
+        for (int i = 0; i < MAX_THREAD_COUNT; ++i) {
+            SDL_AtomicSet(&buffers_[i].state, FREE_STATE);
+            buffers_[i].threadId = 0;
+            SDL_AtomicSet(&buffers_[i].eventCount, 0);
+        }
+    }
+
+    void Tracer::addEvent(char const *name, Uint64 startCounter, Uint64 endCounter)
+    {
+        Buffer *buffer = getBuffer();
+        if (buffer == 0) {
+            return;
+        }
+
+        // Only the owning thread writes to the buffer. Publish the event
+        // after it has been written.
+        int eventCount = SDL_AtomicGet(&buffer->eventCount);
+        Event &event = buffer->events[eventCount % capacity_];
+        event.name = name;
+        event.startCounter = startCounter;
+        event.endCounter = endCounter;
+        ++eventCount;
+        if (eventCount == 2 * capacity_) {
+            eventCount = capacity_;
+        }
+        SDL_AtomicSet(&buffer->eventCount, eventCount);
+    }
+
+    void Tracer::write(std::ostream *out)
+    {
+        *out << "{\"traceEvents\":[";
+        bool first = true;
+        for (int i = 0; i < MAX_THREAD_COUNT; ++i) {
+            Buffer &buffer = buffers_[i];
+            if (SDL_AtomicGet(&buffer.state) != READY_STATE) {
+                continue;
+            }
+
+            if (!first) {
+                *out << ",";
+            }
+            first = false;
+            *out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+                 << ",\"args\":{\"name\":\"thread " << i << "\"}}";
+
+            // The oldest events have been overwritten if the ring buffer
+            // has wrapped around.
+            int eventCount = SDL_AtomicGet(&buffer.eventCount);
+            int oldest = (eventCount < capacity_) ? 0 : eventCount % capacity_;
+            int count = std::min(eventCount, capacity_);
+            for (int j = 0; j < count; ++j) {
+                Event const &event = buffer.events[(oldest + j) % capacity_];
+                double start = double(event.startCounter - startCounter_) * microsecondsPerCount_;
+                double duration = double(event.endCounter - event.startCounter) * microsecondsPerCount_;
+                *out << ",\n{\"name\":\"" << event.name
+                     << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << i
+                     << ",\"ts\":" << start << ",\"dur\":" << duration << "}";
+            }
+        }
+        *out << "\n]}\n";
+    }
+
+    void Tracer::write(char const *path)
+    {
+        std::ofstream out(path);
+        if (!out) {
+            std::stringstream message;
+            message << "Failed to open trace file \"" << path << "\"";
+            throw Error(message.str());
+        }
+        out.precision(15);
+        write(&out);
+    }
+
+    Tracer::Buffer *Tracer::getBuffer()
+    {
+        SDL_threadID threadId = SDL_ThreadID();
+        for (int i = 0; i < MAX_THREAD_COUNT; ++i) {
+            Buffer &buffer = buffers_[i];
+            int state = SDL_AtomicGet(&buffer.state);
+            if (state == READY_STATE && buffer.threadId == threadId) {
+                return &buffer;
+            }
+            if (state == FREE_STATE &&
+                SDL_AtomicCAS(&buffer.state, FREE_STATE, CLAIMED_STATE))
+            {
+                buffer.threadId = threadId;
+                buffer.events.resize(capacity_);
+                SDL_AtomicSet(&buffer.state, READY_STATE);
+                return &buffer;
+            }
+        }
+
+        // Too many threads. Drop the event.
+        return 0;
+    }
+}
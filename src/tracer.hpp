@@ -0,0 +1,97 @@
+#ifndef CRUST_TRACER_HPP
+#define CRUST_TRACER_HPP
+
+#include <iosfwd>
+#include <vector>
+#include <SDL/SDL.h>
+
+namespace crust {
+    // Records timed events into a ring buffer per thread, and writes them
+    // in the Chrome trace event format. Each thread only writes to its own
+    // buffer, so recording takes no locks.
+    class Tracer {
+    public:
+        explicit Tracer(int capacity = 65536);
+
+        Uint64 getCounter() const
+        {
+            return SDL_GetPerformanceCounter();
+        }
+
+        // The name must be a string literal or otherwise outlive the
+        // tracer.
+        void addEvent(char const *name, Uint64 startCounter, Uint64 endCounter);
+
+        void write(std::ostream *out);
+        void write(char const *path);
+
+    private:
+        enum {
+            MAX_THREAD_COUNT = 16
+        };
+
+        enum BufferState {
+            FREE_STATE,
+            CLAIMED_STATE,
+            READY_STATE
+        };
+
+        class Event {
+        public:
+            char const *name;
+            Uint64 startCounter;
+            Uint64 endCounter;
+        };
+
+        class Buffer {
+        public:
+            SDL_atomic_t state;
+            SDL_threadID threadId;
+
+            // Counts up to twice the capacity, then wraps back to the
+            // capacity. At or above the capacity, the buffer is full and
+            // the count modulo the capacity is the oldest event.
+            SDL_atomic_t eventCount;
+            std::vector<Event> events;
+        };
+
+        int capacity_;
+        Uint64 startCounter_;
+        double microsecondsPerCount_;
+        Buffer buffers_[MAX_THREAD_COUNT];
+
+        Buffer *getBuffer();
+
+        // Noncopyable.
+        Tracer(Tracer const &other);
+        Tracer &operator=(Tracer const &other);
+    };
+
+    // Records the enclosing scope as an event of the tracer, if any.
+    class TraceZone {
+    public:
+        TraceZone(Tracer *tracer, char const *name) :
+            tracer_(tracer),
+            name_(name),
+            startCounter_(tracer ? tracer->getCounter() : 0)
+        { }
+
+        ~TraceZone()
+        {
+            if (tracer_) {
+                tracer_->addEvent(name_, startCounter_, tracer_->getCounter());
+            }
+        }
+
+    private:
+        Tracer *tracer_;
+        char const *name_;
+        Uint64 startCounter_;
+
+        // Noncopyable.
+        TraceZone(TraceZone const &other);
+        TraceZone &operator=(TraceZone const &other);
+    };
+}
+
+#endif
@@ -0,0 +1,142 @@
+#include "asset_pack.hpp"
+#include "error.hpp"
+#include "font.hpp"
+#include "font_packer.hpp"
+#include "font_reader.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace crust {
+    bool readFile(std::string const &path, std::vector<char> *result)
+    {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        result->assign(std::istreambuf_iterator<char>(in),
+                       std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    class AssetPacker {
+    public:
+        void addAsset(char const *name, std::vector<char> const &data)
+        {
+            if (std::strlen(name) >= AssetPack::NAME_SIZE) {
+                std::stringstream message;
+                message << "Asset name too long: " << name;
+                throw Error(message.str());
+            }
+            names_.push_back(name);
+            assets_.push_back(data);
+        }
+
+        void write(char const *path)
+        {
+            std::vector<char> pack;
+            std::size_t tableSize = (sizeof(AssetPack::Header) +
+                                     assets_.size() * sizeof(AssetPack::Entry));
+            pack.resize(tableSize, 0);
+
+            AssetPack::Header header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.magic, AssetPack::getMagic(), 4);
+            header.version = AssetPack::VERSION;
+            header.entryCount = boost::uint32_t(assets_.size());
+            std::memcpy(&pack[0], &header, sizeof(header));
+
+            for (std::size_t i = 0; i < assets_.size(); ++i) {
+                pack.resize((pack.size() + AssetPack::ALIGNMENT - 1) /
+                            AssetPack::ALIGNMENT * AssetPack::ALIGNMENT, 0);
+
+                AssetPack::Entry entry;
+                std::memset(&entry, 0, sizeof(entry));
+                std::strcpy(entry.name, names_[i].c_str());
+                entry.offset = boost::uint32_t(pack.size());
+                entry.size = boost::uint32_t(assets_[i].size());
+                std::memcpy(&pack[sizeof(header) + i * sizeof(entry)], &entry,
+                            sizeof(entry));
+
+                pack.insert(pack.end(), assets_[i].begin(), assets_[i].end());
+            }
+
+            // The game projects pack before every build. Leave an
+            // unchanged pack alone, since a running game may have it mapped.
+            std::vector<char> oldPack;
+            if (readFile(path, &oldPack) && oldPack == pack) {
+                return;
+            }
+
+            std::ofstream out(path, std::ios::binary);
+            out.write(&pack.front(), pack.size());
+            if (!out) {
+                std::stringstream message;
+                message << "Failed to write asset pack: " << path;
+                throw Error(message.str());
+            }
+        }
+
+    private:
+        std::vector<std::string> names_;
+        std::vector<std::vector<char> > assets_;
+    };
+
+    void addFile(AssetPacker *packer, std::string const &dataPath,
+                 char const *name, bool required)
+    {
+        std::vector<char> data;
+        if (readFile(dataPath + "/" + name, &data)) {
+            packer->addAsset(name, data);
+        } else if (required) {
+            std::stringstream message;
+            message << "Failed to read asset: " << dataPath << "/" << name;
+            throw Error(message.str());
+        }
+    }
+
+    void addFont(AssetPacker *packer, std::string const &dataPath)
+    {
+        std::string path = dataPath + "/font.txt";
+        std::ifstream in(path.c_str());
+        if (!in.is_open()) {
+            std::stringstream message;
+            message << "Failed to read font: " << path;
+            throw Error(message.str());
+        }
+        Font font;
+        FontReader reader;
+        reader.read(&in, &font);
+        std::vector<char> data;
+        FontPacker fontPacker;
+        fontPacker.write(&font, &data);
+        packer->addAsset("font", data);
+    }
+}
+
+// Bakes the font, the shaders and the config from the data directory into
+// a single asset pack for the game to map at startup.
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        std::cerr << "Usage: crust-packer <data directory> <asset pack>" << std::endl;
+        return 1;
+    }
+    try {
+        crust::AssetPacker packer;
+        crust::addFont(&packer, argv[1]);
+        crust::addFile(&packer, argv[1], "vertex.glsl", true);
+        crust::addFile(&packer, argv[1], "fragment.glsl", true);
+        crust::addFile(&packer, argv[1], "config.txt", false);
+        packer.write(argv[2]);
+    } catch (crust::Error const &error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}